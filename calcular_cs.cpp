@@ -1,110 +1,81 @@
 #include "sketchs/countsketch.hpp"
+#include "sketchs/candidatosheavyhitters.hpp"
+#include "sketchs/hyperloglog.hpp"
 #include "utils/LectorGenomas.hpp"
-#include <unordered_set>
+#include "utils/IngestaParalela.hpp"
+#include "utils/OpcionesEjecucion.hpp"
 #include <algorithm>
 #include <fstream>
+#include <filesystem>
 #include <iomanip>
 #include <chrono>
 
-// Función para obtener k-mer canónico
-std::string getCanonicalKmer(const std::string& kmer) {
-    std::string revComp = kmer;
-    
-    // Crear complemento reverso
-    for (char& c : revComp) {
-        switch(c) {
-            case 'A': c = 'T'; break;
-            case 'T': c = 'A'; break;
-            case 'C': c = 'G'; break;
-            case 'G': c = 'C'; break;
-        }
+// Sketch y estadísticas de una longitud de k-mer
+struct ProcesoK {
+    int k;
+    double phi;
+    CountSketch sketch;
+    long long totalKmers = 0;
+    CandidatosHeavyHitters candidatos;
+    HyperLogLog distintos;
+
+    ProcesoK(int k, double phi, const CountSketch& sketch) : k(k), phi(phi), sketch(sketch), candidatos(phi) {}
+
+    // combina la réplica de un hilo (ver ingestarProcesos)
+    void merge(const ProcesoK& replica) {
+        sketch.merge(replica.sketch);
+        candidatos.merge(replica.candidatos);
+        distintos.merge(replica.distintos);
     }
-    std::reverse(revComp.begin(), revComp.end());
-    
-    // Retornar el lexicográficamente menor
-    return std::min(kmer, revComp);
-}
 
-// Función para procesar k-mers de una longitud específica
-std::vector<std::pair<std::string, int>> procesarCountSketch(int k, double phi, const std::string& titulo) {
+    DiferenciasEstimacion verificar(ProcesoK& vacio, LectorGenomas& lector) const {
+        return compararConSecuencial(sketch, vacio.sketch, lector, k, candidatos.getCandidatos());
+    }
+
+    std::string progreso() const {
+        return "Candidatos: " + std::to_string(candidatos.size());
+    }
+};
+
+// Busca los heavy hitters de un k ya ingerido, los muestra y los guarda en CSV
+std::vector<std::pair<std::string, int>> procesarCountSketch(const ProcesoK& proceso, const std::string& titulo) {
     std::cout << "\n=== " << titulo << " ===" << std::endl;
     
-    //Parámetros del CountSketch
-    int d = 7;
-    int w = 35000;
-    
-    CountSketch sketch(d, w);
-    LectorGenomas reader("Genomas");
-    
-    //Estadísticas
-    long long totalKmers = 0;
-    int processedFiles = 0;
-    std::unordered_set<std::string> uniqueKmers;
-    
-    std::cout << "Procesando k-mers de longitud " << k << std::endl;
-    
-    do {
-        if (processedFiles % 10 == 0) {
-            std::cout << "Procesando archivo " << (processedFiles + 1) << std::endl;
-        }
-        
-        long long fileKmers = 0;
-        reader.reset();
-        
-        while (reader.hasMoreKmers(k)) {
-            std::string kmer = reader.getNextKmer(k);
-            if (!kmer.empty()) {
-                bool validKmer = true;
-                for (char c : kmer) {
-                    if (c != 'A' && c != 'T' && c != 'C' && c != 'G') {
-                        validKmer = false;
-                        break;
-                    }
-                }
-                
-                if (validKmer) {
-                    std::string canonical = getCanonicalKmer(kmer);
-                    sketch.insert(canonical);
-                    uniqueKmers.insert(canonical);
-                    fileKmers++;
-                    totalKmers++;
-                    
-                    // Progreso cada 1M k-mers
-                    if (totalKmers % 1000000 == 0) {
-                        std::cout << "\rProcesados: " << totalKmers << " k-mers, Únicos: " << uniqueKmers.size() << std::flush;
-                    }
-                }
-            }
-        }
-        std::cout << std::endl;
-        
-        processedFiles++;
-        
-    } while (reader.nextFile());
+    const int k = proceso.k;
+    const double phi = proceso.phi;
+    const CountSketch& sketch = proceso.sketch;
+    const long long totalKmers = proceso.totalKmers;
+    const std::vector<uint64_t> candidatos = proceso.candidatos.getCandidatos();
     
     std::cout << "\nEstadísticas " << k << "-mers:" << std::endl;
     std::cout << "Total procesados: " << totalKmers << std::endl;
-    std::cout << "Únicos encontrados: " << uniqueKmers.size() << std::endl;
-    std::cout << "Archivos procesados: " << processedFiles << std::endl;
+    std::cout << "Distintos estimados (HyperLogLog): " << (long long)std::llround(proceso.distintos.estimate())
+              << " (error esperado " << 100 * proceso.distintos.errorEstandar() << "%)" << std::endl;
+    std::cout << "Candidatos a heavy hitter: " << candidatos.size() << " (capacidad "
+              << proceso.candidatos.getCapacidad() << ")" << std::endl;
     
 
     int umbralFrecuencia = static_cast<int>(phi * totalKmers);
     std::cout << "Umbral φ = " << phi << " frecuencia >= " << umbralFrecuencia << std::endl;
     
     std::vector<std::pair<std::string, int>> heavyHitters;
-    std::cout << "Evaluando " << uniqueKmers.size() << " k-mers únicos" << std::endl;
+    std::cout << "Evaluando " << candidatos.size() << " candidatos" << std::endl;
+    
+    std::vector<int> estimaciones(candidatos.size());
+    sketch.estimateBatch(candidatos.data(), candidatos.size(), estimaciones.data());
     
     int evaluatedCount = 0;
-    for (const std::string& kmer : uniqueKmers) {
-        int estimatedFreq = sketch.estimate(kmer);
+    for (size_t c = 0; c < candidatos.size(); c++) {
+        uint64_t kmer = candidatos[c];
+        int estimatedFreq = estimaciones[c];
         
         if (estimatedFreq >= umbralFrecuencia) {
-            heavyHitters.emplace_back(kmer, estimatedFreq);
+            heavyHitters.emplace_back(decodificarKmer(kmer, k), estimatedFreq);
         }
         
         evaluatedCount++;
         if (evaluatedCount % 100000 == 0) {
-            std::cout << "\rEvaluados: " << evaluatedCount << "/" << uniqueKmers.size() 
+            std::cout << "\rEvaluados: " << evaluatedCount << "/" << candidatos.size() 
                      << ", HH encontrados: " << heavyHitters.size() << std::flush;
         }
     }
@@ -156,16 +127,37 @@ std::vector<std::pair<std::string, int>> procesarCountSketch(int k, double phi,
     return heavyHitters;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
+        OpcionesEjecucion opciones = leerOpciones(argc, argv);
+        
         std::cout << "|--------------------------------------------------------------|" << std::endl;
         std::cout << "|           COUNTSKETCH PARA 21-MERS Y 31-MERS                 |" << std::endl;
         std::cout << "|--------------------------------------------------------------|" << std::endl;
         
-        LectorGenomas testReader("Genomas");
+        //Parámetros del CountSketch
+        int d = 7;
+        int w = 35000;
+        
+        // 21-mers y 31-mers se extraen en la misma pasada por los genomas
+        std::vector<ProcesoK> procesos;
+        procesos.emplace_back(21, 2e-6, CountSketch(d, w));
+        procesos.emplace_back(31, 4e-6, CountSketch(d, w));
+        ingestarProcesos(procesos, opciones, [](ProcesoK& p, const uint64_t* kmers, size_t n) {
+            p.candidatos.insertarEn(p.sketch, kmers, n);
+            p.distintos.insertBatch(kmers, n);
+        });
+        if (!opciones.directorioSketches.empty()) {
+            std::filesystem::create_directories(opciones.directorioSketches);
+            for (const ProcesoK& p : procesos) {
+                std::string ruta = opciones.directorioSketches + "/countsketch_" + std::to_string(p.k) + "mer.sketch";
+                p.sketch.save(ruta, p.k);
+                std::cout << "Sketch guardado en: " << ruta << std::endl;
+            }
+        }
         
-        auto heavyHitters21 = procesarCountSketch(21, 2e-6, "Procesando 21-mers");  
-        auto heavyHitters31 = procesarCountSketch(31, 4e-6, "Procesando 31-mers");
+        auto heavyHitters21 = procesarCountSketch(procesos[0], "Heavy hitters 21-mers");
+        auto heavyHitters31 = procesarCountSketch(procesos[1], "Heavy hitters 31-mers");
         
         // Resumen final
         std::cout << "\n|----------------------------------------------------------------|" << std::endl;
@@ -0,0 +1,137 @@
+#include "sketchs/spacesaving.hpp"
+#include "utils/LectorGenomas.hpp"
+#include "utils/IngestaParalela.hpp"
+#include "utils/OpcionesEjecucion.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+// Resumen Space-Saving y estadísticas de una longitud de k-mer
+struct ProcesoK {
+    int k;
+    double phi;
+    SpaceSaving resumen;
+    long long totalKmers = 0;
+
+    ProcesoK(int k, double phi) : k(k), phi(phi), resumen(SpaceSaving::capacidadPara(phi)) {}
+
+    // combina la réplica de un hilo (ver ingestarProcesos)
+    void merge(const ProcesoK& replica) {
+        resumen.merge(replica.resumen);
+    }
+
+    DiferenciasEstimacion verificar(ProcesoK& vacio, LectorGenomas& lector) const {
+        std::vector<uint64_t> monitoreados;
+        for (const SpaceSaving::Frecuente& f : resumen.getFrecuentes(0)) monitoreados.push_back(f.kmer);
+        return compararConSecuencial(resumen, vacio.resumen, lector, k, monitoreados);
+    }
+
+    std::string progreso() const {
+        return "Cuenta mínima: " + std::to_string(resumen.getMinimo());
+    }
+};
+
+// Lista los heavy hitters de un k ya ingerido, los muestra y los guarda en CSV
+std::vector<std::pair<std::string, int>> procesarSpaceSaving(const ProcesoK& proceso, const std::string& titulo) {
+    std::cout << "\n=== " << titulo << " ===" << std::endl;
+
+    const int k = proceso.k;
+    const double phi = proceso.phi;
+    const SpaceSaving& resumen = proceso.resumen;
+    const long long totalKmers = proceso.totalKmers;
+
+    std::cout << "\nEstadísticas " << k << "-mers:" << std::endl;
+    std::cout << "Total procesados: " << totalKmers << std::endl;
+    std::cout << "Contadores: " << resumen.size() << " (capacidad " << resumen.getCapacidad()
+              << ", " << resumen.getSize() / (1024 * 1024) << " MiB)" << std::endl;
+    std::cout << "Error máximo por cuenta: " << resumen.getMinimo() << std::endl;
+
+    int umbralFrecuencia = static_cast<int>(phi * totalKmers);
+    std::cout << "Umbral φ = " << phi << " frecuencia >= " << umbralFrecuencia << std::endl;
+
+    // Todo k-mer con f >= umbral está entre los monitoreados con cuenta >= umbral
+    std::vector<SpaceSaving::Frecuente> frecuentes = resumen.getFrecuentes(umbralFrecuencia);
+    std::vector<std::pair<std::string, int>> heavyHitters;
+    int garantizados = 0;
+    for (const SpaceSaving::Frecuente& f : frecuentes) {
+        heavyHitters.emplace_back(decodificarKmer(f.kmer, k), f.cuenta);
+        if (f.cuenta - f.error >= umbralFrecuencia) garantizados++;
+    }
+
+    std::cout << "Heavy hitters " << k << "-mers encontrados: " << heavyHitters.size()
+              << " (" << garantizados << " garantizados: cuenta - error >= umbral)" << std::endl;
+
+    // Mostrar top 10
+    if (!heavyHitters.empty()) {
+        std::cout << "\nTop 10 Heavy Hitters " << k << "-mers:" << std::endl;
+        std::cout << "Rank\tFrecuencia\tError\tK-mer" << std::endl;
+        std::cout << "----------------------------------------" << std::endl;
+
+        int showCount = std::min(10, (int)heavyHitters.size());
+        for (int i = 0; i < showCount; i++) {
+            std::cout << (i+1) << "\t" << heavyHitters[i].second << "\t\t" << frecuentes[i].error
+                     << "\t" << heavyHitters[i].first << std::endl;
+        }
+    }
+
+    // Guardar en CSV, con el mismo formato que calcular_cs
+    std::string csvFilename = "CSV/spacesaving_heavy_hitters_" + std::to_string(k) + "mers.csv";
+    std::ofstream csvFile(csvFilename);
+
+    if (csvFile.is_open()) {
+        csvFile << "rank,kmer,estimated_frequency,threshold_used,total_kmers,phi_value,kmer_length\n";
+
+        for (size_t i = 0; i < heavyHitters.size(); i++) {
+            csvFile << (i + 1) << ","
+                   << heavyHitters[i].first << ","
+                   << heavyHitters[i].second << ","
+                   << umbralFrecuencia << ","
+                   << totalKmers << ","
+                   << std::scientific << std::setprecision(1) << phi << ","
+                   << k << "\n";
+        }
+
+        csvFile.close();
+        std::cout << "Guardado en: " << csvFilename << std::endl;
+        std::cout << "Registros: " << heavyHitters.size() << std::endl;
+    } else {
+        std::cerr << "Error creando CSV: " << csvFilename << std::endl;
+    }
+
+    return heavyHitters;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        OpcionesEjecucion opciones = leerOpciones(argc, argv);
+
+        std::cout << "|--------------------------------------------------------------|" << std::endl;
+        std::cout << "|           SPACE-SAVING PARA 21-MERS Y 31-MERS                |" << std::endl;
+        std::cout << "|--------------------------------------------------------------|" << std::endl;
+
+        // La capacidad de cada resumen sale de φ: 2/φ contadores, error <= φ·N/2
+        std::vector<ProcesoK> procesos;
+        procesos.emplace_back(21, 2e-6);
+        procesos.emplace_back(31, 4e-6);
+        ingestarProcesos(procesos, opciones, [](ProcesoK& p, const uint64_t* kmers, size_t n) {
+            p.resumen.insertBatch(kmers, n);
+        });
+
+        auto heavyHitters21 = procesarSpaceSaving(procesos[0], "Heavy hitters 21-mers");
+        auto heavyHitters31 = procesarSpaceSaving(procesos[1], "Heavy hitters 31-mers");
+
+        // Resumen final
+        std::cout << "\n|----------------------------------------------------------------|" << std::endl;
+        std::cout << "|                    RESUMEN FINAL                               |" << std::endl;
+        std::cout << "|----------------------------------------------------------------|" << std::endl;
+
+        std::cout << "21-mers Heavy Hitters: " << heavyHitters21.size() << std::endl;
+        std::cout << "31-mers Heavy Hitters: " << heavyHitters31.size() << std::endl;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
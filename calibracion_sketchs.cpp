@@ -1,149 +1,257 @@
 #include <iostream>
 #include <fstream>
-#include <unordered_map>
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <thread>
 #include "sketchs/towersketch.hpp"
 #include "sketchs/countsketch.hpp"
+#include "sketchs/countsketchbloques.hpp"
+#include "sketchs/contadorexacto.hpp"
 #include "utils/LectorGenomas.hpp"
+#include "utils/IngestaParalela.hpp"
+#include "utils/MotorCalibracion.hpp"
+#include "utils/OpcionesEjecucion.hpp"
 
 using namespace std;
 
 struct ResultadosError {
     double mae;
     double mre;
+    double maeIC;       // semiancho del intervalo de confianza del 95% (0 si se evaluaron todos)
+    double mreIC;
+    size_t evaluados;
 };
 
+// Sumas de error de un tramo de la tabla del ground truth
+struct SumasError {
+    double absoluto = 0.0, absoluto2 = 0.0;
+    double relativo = 0.0, relativo2 = 0.0;
+    size_t n = 0;
+};
+
+// Tramos fijos de la tabla, para que el resultado no dependa del número de hilos
+const size_t TRAMOS_EVALUACION = 256;
+// Semilla de la muestra, distinta de las de los sketches y de la tabla del ground truth
+const uint64_t SEMILLA_MUESTRA = 0x6D75657374726121ULL;
+
+// Semiancho del intervalo del 95% para una media de n de N valores, con corrección de población finita
+double semianchoIC(double suma, double suma2, size_t n, size_t N) {
+    if (n < 2 || n >= N) return 0.0;
+    double media = suma / n;
+    double varianza = std::max(0.0, (suma2 - n * media * media) / (n - 1));
+    return 1.96 * sqrt(varianza / n) * sqrt(1.0 - (double)n / N);
+}
+
+/**
+ * MAE y MRE del sketch sobre los k-mers distintos del ground truth
+ * La tabla se divide en TRAMOS_EVALUACION tramos que los hilos toman de a uno, cada uno con
+ * sus propias sumas. Con muestra < 1 se evalúa solo una muestra uniforme de los k-mers
+ * distintos (los de mixhash64(kmer, SEMILLA_MUESTRA) < muestra·2^64, la misma para todos
+ * los sketches) y se reporta el intervalo de confianza del 95% de cada media.
+ */
 template <typename SketchType>
 ResultadosError calcularErrores(
-    unordered_map<string,int>& groundTruth,
-    SketchType& sketch
+    const ContadorExacto& groundTruth,
+    const SketchType& sketch,
+    int hilos,
+    double muestra = 1.0
 ) {
-    double mae = 0.0, mre = 0.0;
-    int n = 0;
+    const size_t celdas = groundTruth.getCeldas();
+    const bool muestreo = muestra < 1.0;
+    const uint64_t limiteMuestra = muestreo ? (uint64_t)(muestra * 18446744073709551616.0) : UINT64_MAX;
 
-    for (auto& kv : groundTruth) {
-        const string& kmer = kv.first;
-        int real = kv.second;
-        int estimado = sketch.estimate(kmer);
-
-        mae += abs(real - estimado);
-        if (real > 0) {
-            mre += (double)abs(real - estimado) / real;
+    vector<SumasError> sumas(TRAMOS_EVALUACION);
+    atomic<size_t> siguiente(0);
+    auto trabajar = [&]() {
+        size_t t;
+        while ((t = siguiente.fetch_add(1)) < TRAMOS_EVALUACION) {
+            SumasError s;
+            groundTruth.paraCada(celdas * t / TRAMOS_EVALUACION, celdas * (t + 1) / TRAMOS_EVALUACION,
+                                 [&](uint64_t kmer, uint32_t cuenta) {
+                if (muestreo && mixhash64(kmer, SEMILLA_MUESTRA) >= limiteMuestra) return;
+                int real = (int)cuenta;
+                int estimado = sketch.estimate(kmer);
+                double absoluto = abs(real - estimado);
+                double relativo = (real > 0) ? absoluto / real : 0.0;
+                s.absoluto += absoluto;
+                s.absoluto2 += absoluto * absoluto;
+                s.relativo += relativo;
+                s.relativo2 += relativo * relativo;
+                s.n++;
+            });
+            sumas[t] = s;
         }
-        n++;
-    }
+    };
+    vector<thread> trabajadores;
+    for (int h = 1; h < hilos; h++) trabajadores.emplace_back(trabajar);
+    trabajar();
+    for (thread& t : trabajadores) t.join();
 
-    if (n > 0) {
-        mae /= n;
-        mre /= n;
+    SumasError total;
+    for (const SumasError& s : sumas) {
+        total.absoluto += s.absoluto;
+        total.absoluto2 += s.absoluto2;
+        total.relativo += s.relativo;
+        total.relativo2 += s.relativo2;
+        total.n += s.n;
     }
 
-    return {mae, mre};
-}
-
-std::string revComp(const std::string &s) {
-    std::string rc = s;
-    for (char &c : rc) {
-        switch(c) {
-            case 'A': c='T'; break;
-            case 'T': c='A'; break;
-            case 'C': c='G'; break;
-            case 'G': c='C'; break;
+    ResultadosError res{0.0, 0.0, 0.0, 0.0, total.n};
+    if (total.n > 0) {
+        res.mae = total.absoluto / total.n;
+        res.mre = total.relativo / total.n;
+        if (muestreo) {
+            res.maeIC = semianchoIC(total.absoluto, total.absoluto2, total.n, groundTruth.size());
+            res.mreIC = semianchoIC(total.relativo, total.relativo2, total.n, groundTruth.size());
         }
     }
-    std::reverse(rc.begin(), rc.end());
-    return rc;
+    return res;
 }
 
-std::string canonical(const std::string &s) {
-    std::string rc = revComp(s);
-    return std::min(s, rc);
+// " ± semiancho" si hay intervalo de confianza
+string formatoIC(double semiancho) {
+    return (semiancho > 0.0) ? " ± " + to_string(semiancho) : "";
 }
 
-int main() {
-    int k = 31;
-    string dir = "Genomas";
+int main(int argc, char* argv[]) {
+    try {
+        OpcionesEjecucion opciones = leerOpciones(argc, argv);
+        int k = 31;
+        int hilos = (opciones.hilos == 0) ? hilosDisponibles() : opciones.hilos;
 
-    LectorGenomas lector(dir);
-    unordered_map<string,int> groundTruth;
+        LectorGenomas lector(opciones.entrada, opciones.modoLectura, opciones.lecturaAnticipada,
+                             opciones.calidadMinima);
 
-    cout << "Generando ground truth..." << endl;
-    while (lector.hasMoreKmers(k)) {
-        string kmer = lector.getNextKmer(k);
-        if (kmer.empty()) break;
-        groundTruth[canonical(kmer)]++;
-    }
-    cout << "Se cargaron " << groundTruth.size() << " k-mers únicos" << endl;
-
-    std::string archivocsv = "results_calibracion/calibracion_countsketch_" + std::to_string(k) + "mer.csv";
-    ofstream out(archivocsv);
-    out << "sketch,d,w,tamano,mae,mre\n";
-
-    vector<int> d_vals = {5, 7};
-    vector<int> w_vals = {25000, 35000, 40000};
-
-    
-    
-    for (int d : d_vals) {
-        for (int w : w_vals) {
-            CountSketch cs(d, w);
-
-            lector.reset();
-            while (lector.hasMoreKmers(k)) {
-                string kmer = lector.getNextKmer(k);
-                if (kmer.empty()) break;
-                cs.insert(kmer);
+        vector<int> d_vals = {5, 7};
+        vector<int> w_vals = {25000, 35000, 40000};
+        std::vector<int> w8_vals = {70000, 90000};
+        std::vector<int> w16_vals = {20000, 30000};
+        std::vector<int> w32_vals = {2000};
+
+        // Toda la grilla se crea de antemano y se llena en una sola pasada (ver MotorCalibracion);
+        // el costo de cada sketch son las líneas de caché que toca por k-mer
+        vector<CountSketch> cs;
+        vector<CountSketchBloques> csb;
+        vector<TowerSketch> ts;
+        for (int d : d_vals) {
+            for (int w : w_vals) {
+                cs.emplace_back(d, w);
+                csb.emplace_back(d, w);
             }
+        }
+        for (int d : d_vals) {
+            for (int w8 : w8_vals) {
+                for (int w16 : w16_vals) {
+                    for (int w32 : w32_vals) {
+                        ts.emplace_back(d, w8, d, w16, d, w32);
+                    }
+                }
+            }
+        }
 
-            auto res = calcularErrores(groundTruth, cs);
-            int totalSize = d * w * sizeof(int);
-            out << "CS," << d << "," << w << "," << totalSize << ","
-                << res.mae << "," << res.mre << "\n";
+        MotorCalibracion motor;
+        vector<size_t> puntosCS, puntosCSB, puntosTS;
+        for (size_t i = 0; i < cs.size(); i++) {
+            puntosCS.push_back(motor.agregar(cs[i], d_vals[i / w_vals.size()]));
+            puntosCSB.push_back(motor.agregar(csb[i], 1));
+        }
+        for (size_t i = 0; i < ts.size(); i++) {
+            TowerSketch& sketch = ts[i];
+            puntosTS.push_back(motor.agregar(sketch.getSemilla(), d_vals[i / (ts.size() / d_vals.size())],
+                [&sketch](const uint64_t* kmers, const HashFilas* hashes, size_t n) {
+                    sketch.insertBatch(kmers, hashes, n);
+                }));
+        }
 
-            cout << "[CS] d=" << d << ", w=" << w
-                 << " -> MAE=" << res.mae << ", MRE=" << res.mre << endl;
+        // El ground truth se cuenta en el hilo lector durante la misma pasada
+        ContadorExacto groundTruth;
+        cout << "Llenando " << motor.size() << " sketches y el ground truth en una sola pasada con "
+             << hilos << " hilos..." << endl;
+        auto inicio = chrono::steady_clock::now();
+        long long total = motor.ejecutar(lector, k, hilos, [&](const uint64_t* kmers, size_t n) {
+            groundTruth.insertBatch(kmers, n);
+        });
+        double segundosPasada = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+        cout << "Se procesaron " << total << " k-mers en " << segundosPasada << "s; se cargaron "
+             << groundTruth.size() << " k-mers únicos" << endl;
+        if (opciones.muestra < 1.0) {
+            cout << "El error se evalúa sobre una muestra de " << 100 * opciones.muestra
+                 << "% de los k-mers únicos (intervalos de confianza del 95%)" << endl;
         }
-    }
-    cout << "Resultados guardados en " << archivocsv << endl;
-    
-    archivocsv = "results_calibracion/calibracion_towersketch_" + std::to_string(k) + "mer.csv";
-    ofstream tsout(archivocsv);
-    tsout << "sketch,d,w8,w16,w32,tamano,mae,mre\n";
-
-    std::vector<int> w8_vals = {70000, 90000};
-    std::vector<int> w16_vals = {20000, 30000};
-    std::vector<int> w32_vals = {2000};
-
-    for (int d : d_vals) {
-        for (int w8 : w8_vals) {
-            for (int w16 : w16_vals) {
-                for (int w32 : w32_vals) {
-                    TowerSketch ts(d, w8, d, w16, d, w32);
-
-                    lector.reset();
-                    while (lector.hasMoreKmers(k)) {
-                        string kmer = lector.getNextKmer(k);
-                        if (kmer.empty()) break;
-                        ts.insert(kmer);
-                    }
 
-                    auto res = calcularErrores(groundTruth, ts);
-                    size_t totalSize = ts.getSize();
-                    tsout << "TS," << d << "," << w8 << "," << w16 << "," << w32 << "," << totalSize << ","
-                        << res.mae << "," << res.mre << "\n";
+        std::string archivocsv = "results_calibracion/calibracion_countsketch_" + std::to_string(k) + "mer.csv";
+        ofstream out(archivocsv);
+        out << "sketch,d,w,tamano,mae,mre,mae_ic95,mre_ic95\n";
+
+        // Comparación del CountSketch normal contra la variante por bloques con la misma memoria;
+        // segundos es el tiempo de las actualizaciones de cada sketch dentro de la pasada
+        std::string archivoBloques = "results_calibracion/calibracion_countsketch_bloques_" + std::to_string(k) + "mer.csv";
+        ofstream bloquesOut(archivoBloques);
+        bloquesOut << "sketch,d,w,tamano,mae,mre,segundos,mae_ic95,mre_ic95\n";
+
+        size_t i = 0;
+        for (int d : d_vals) {
+            for (int w : w_vals) {
+                double segundos = motor.getSegundos(puntosCS[i]);
+
+                auto res = calcularErrores(groundTruth, cs[i], hilos, opciones.muestra);
+                int totalSize = d * w * sizeof(int);
+                out << "CS," << d << "," << w << "," << totalSize << ","
+                    << res.mae << "," << res.mre << "," << res.maeIC << "," << res.mreIC << "\n";
+                bloquesOut << "CS," << d << "," << w << "," << totalSize << ","
+                    << res.mae << "," << res.mre << "," << segundos << "," << res.maeIC << "," << res.mreIC << "\n";
 
-                    cout << "[TS] d=" << d << ", w8=" << w8 << ", w16=" << w16 << ", w32=" << w32
-                         << " -> MAE=" << res.mae << ", MRE=" << res.mre << endl;
+                cout << "[CS] d=" << d << ", w=" << w
+                     << " -> MAE=" << res.mae << formatoIC(res.maeIC) << ", MRE=" << res.mre << formatoIC(res.mreIC)
+                     << ", t=" << segundos << "s" << endl;
+
+                segundos = motor.getSegundos(puntosCSB[i]);
+
+                res = calcularErrores(groundTruth, csb[i], hilos, opciones.muestra);
+                bloquesOut << "CSB," << d << "," << w << "," << csb[i].getSize() << ","
+                    << res.mae << "," << res.mre << "," << segundos << "," << res.maeIC << "," << res.mreIC << "\n";
+
+                cout << "[CSB] d=" << d << ", w=" << w
+                     << " -> MAE=" << res.mae << formatoIC(res.maeIC) << ", MRE=" << res.mre << formatoIC(res.mreIC)
+                     << ", t=" << segundos << "s" << endl;
+                i++;
+            }
+        }
+        cout << "Resultados guardados en " << archivocsv << " y " << archivoBloques << endl;
+
+        archivocsv = "results_calibracion/calibracion_towersketch_" + std::to_string(k) + "mer.csv";
+        ofstream tsout(archivocsv);
+        tsout << "sketch,d,w8,w16,w32,tamano,mae,mre,mae_ic95,mre_ic95\n";
+
+        i = 0;
+        for (int d : d_vals) {
+            for (int w8 : w8_vals) {
+                for (int w16 : w16_vals) {
+                    for (int w32 : w32_vals) {
+                        auto res = calcularErrores(groundTruth, ts[i], hilos, opciones.muestra);
+                        size_t totalSize = ts[i].getSize();
+                        tsout << "TS," << d << "," << w8 << "," << w16 << "," << w32 << "," << totalSize << ","
+                            << res.mae << "," << res.mre << "," << res.maeIC << "," << res.mreIC << "\n";
+
+                        cout << "[TS] d=" << d << ", w8=" << w8 << ", w16=" << w16 << ", w32=" << w32
+                             << " -> MAE=" << res.mae << formatoIC(res.maeIC) << ", MRE=" << res.mre
+                             << formatoIC(res.mreIC) << endl;
+                        i++;
+                    }
                 }
             }
         }
+
+        out.close();
+        cout << "Resultados guardados en " << archivocsv << endl;
+
+    } catch (const std::exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
     }
-    
-   
-    out.close();
-    cout << "Resultados guardados en " << archivocsv << endl;
 
     return 0;
-}
\ No newline at end of file
+}
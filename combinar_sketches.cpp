@@ -0,0 +1,90 @@
+#include "sketchs/countsketch.hpp"
+#include "sketchs/towersketch.hpp"
+#include "sketchs/archivosketch.hpp"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+
+using namespace std;
+
+/**
+ * Combina N archivos de sketch (ver sketchs/archivosketch.hpp) en uno solo
+ *
+ * Pensado para repartir la ingesta: cada archivo de genomas o cada nodo llena su propio
+ * sketch con las mismas dimensiones y semilla (por ejemplo calcular_cs --entrada X --guardar DIR)
+ * y aquí se reducen con merge. Las entradas se abren mapeadas, así que solo se leen sus
+ * contadores una vez, en orden. Todas deben ser del mismo tipo y del mismo k. Un CountSketch
+ * combinado es idéntico al de una sola ingesta; para TowerSketch y CountMinCU la combinación
+ * satura. Un TowerSketch guarda cuántas réplicas suma (las de cada entrada se acumulan), con
+ * lo que su estimación sigue siendo una cota superior (ver TowerSketch::merge).
+ */
+
+void mostrarUsoCombinar(const string& programa) {
+    cout << "Uso: " << programa << " SALIDA ENTRADA1 ENTRADA2 [ENTRADA...]" << endl;
+}
+
+// Carga la primera entrada en memoria propia y le suma las demás, mapeadas
+template <typename SketchType>
+void combinar(const vector<string>& entradas, const string& salida, int k) {
+    SketchType resultado = SketchType::load(entradas[0], false);
+    for (size_t i = 1; i < entradas.size(); i++) {
+        resultado.merge(SketchType::load(entradas[i]));
+        cout << "Combinado " << entradas[i] << endl;
+    }
+    resultado.save(salida, k);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc < 4) {
+            mostrarUsoCombinar(argv[0]);
+            return 1;
+        }
+        string salida = argv[1];
+        vector<string> entradas(argv + 2, argv + argc);
+
+        auto inicio = chrono::steady_clock::now();
+
+        // El tipo y el k salen de la primera entrada; las demás deben coincidir
+        TipoSketch tipo;
+        int k;
+        {
+            LectorSketch primero(entradas[0]);
+            tipo = primero.getTipo();
+            k = primero.getK();
+        }
+        for (size_t i = 1; i < entradas.size(); i++) {
+            LectorSketch lector(entradas[i]);
+            if (lector.getTipo() != tipo) {
+                throw runtime_error(entradas[i] + " guarda un " + nombreTipoSketch(lector.getTipo())
+                                    + " y " + entradas[0] + " un " + nombreTipoSketch(tipo));
+            }
+            if (lector.getK() != k) {
+                throw runtime_error(entradas[i] + " tiene k = " + to_string(lector.getK()) + " y "
+                                    + entradas[0] + " k = " + to_string(k));
+            }
+        }
+        cout << "Combinando " << entradas.size() << " archivos de " << nombreTipoSketch(tipo);
+        if (k > 0) cout << " (k = " << k << ")";
+        cout << endl;
+
+        switch (tipo) {
+            case TipoSketch::CountSketch: combinar<CountSketch>(entradas, salida, k); break;
+            case TipoSketch::CountMinCU8: combinar<CountMinCU<uint8_t>>(entradas, salida, k); break;
+            case TipoSketch::CountMinCU16: combinar<CountMinCU<uint16_t>>(entradas, salida, k); break;
+            case TipoSketch::CountMinCU32: combinar<CountMinCU<uint32_t>>(entradas, salida, k); break;
+            case TipoSketch::TowerSketch: combinar<TowerSketch>(entradas, salida, k); break;
+            default: throw runtime_error("Tipo de sketch desconocido en " + entradas[0]);
+        }
+
+        double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+        cout << "Sketch combinado guardado en " << salida << " (" << segundos << "s)" << endl;
+
+    } catch (const std::exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
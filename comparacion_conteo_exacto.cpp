@@ -0,0 +1,150 @@
+#include "sketchs/contadorexacto.hpp"
+#include "sketchs/contadorordenado.hpp"
+#include "utils/LectorGenomas.hpp"
+#include "utils/IngestaParalela.hpp"
+#include "utils/OpcionesEjecucion.hpp"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * Comparación de los dos motores de conteo exacto de ground_truth, de 1 a N hilos
+ *   - tabla: cada hilo cuenta en su propio ContadorExacto y al final se combinan con merge
+ *   - orden: los hilos acumulan las apariciones sin sincronizarse y ContadorOrdenado las
+ *            ordena con radix sort paralelo
+ * Para cada uno se mide la ingesta (extracción incluida), el conteo posterior (merge u
+ * ordenamiento, más el recorrido que lista los heavy hitters) y la memoria máxima de las
+ * estructuras. Ambos motores deben encontrar los mismos heavy hitters.
+ */
+
+struct Medicion {
+    double segundosIngesta;
+    double segundosConteo;
+    size_t memoriaPico;
+    size_t distintos;
+    vector<pair<uint64_t, uint32_t>> heavyHitters;
+};
+
+static double segundosDesde(chrono::steady_clock::time_point inicio) {
+    return chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+}
+
+template<typename Conteo>
+vector<pair<uint64_t, uint32_t>> listarHeavyHitters(const Conteo& conteo, long long umbral) {
+    vector<pair<uint64_t, uint32_t>> heavyHitters;
+    conteo.paraCada([&](uint64_t kmer, uint32_t cuenta) {
+        if ((long long)cuenta >= umbral) heavyHitters.emplace_back(kmer, cuenta);
+    });
+    sort(heavyHitters.begin(), heavyHitters.end());
+    return heavyHitters;
+}
+
+Medicion medirTabla(LectorGenomas& lector, int k, int hilos, long long umbral) {
+    auto inicio = chrono::steady_clock::now();
+    vector<ContadorExacto> replicas(hilos);
+    ingestarEnParalelo(lector, k, hilos, [&](int h, const uint64_t* kmers, size_t n) {
+        replicas[h].insertBatch(kmers, n);
+    });
+    double segundosIngesta = segundosDesde(inicio);
+
+    inicio = chrono::steady_clock::now();
+    size_t memoriaReplicas = 0;
+    for (const ContadorExacto& r : replicas) memoriaReplicas += r.getSize();
+    // la réplica más grande recibe a las demás
+    size_t mayor = 0;
+    for (int h = 1; h < hilos; h++) {
+        if (replicas[h].size() > replicas[mayor].size()) mayor = h;
+    }
+    size_t tamanoAntes = replicas[mayor].getSize();
+    for (int h = 0; h < hilos; h++) {
+        if ((size_t)h != mayor) replicas[mayor].merge(replicas[h]);
+    }
+    const ContadorExacto& conteo = replicas[mayor];
+    Medicion medicion{segundosIngesta, 0.0, memoriaReplicas - tamanoAntes + conteo.getSize(), conteo.size(),
+                      listarHeavyHitters(conteo, umbral)};
+    medicion.segundosConteo = segundosDesde(inicio);
+    return medicion;
+}
+
+Medicion medirOrden(LectorGenomas& lector, int k, int hilos, long long umbral) {
+    auto inicio = chrono::steady_clock::now();
+    ContadorOrdenado conteo(k, hilos);
+    ingestarEnParalelo(lector, k, hilos, [&](int h, const uint64_t* kmers, size_t n) {
+        conteo.insertBatch(h, kmers, n);
+    });
+    double segundosIngesta = segundosDesde(inicio);
+
+    inicio = chrono::steady_clock::now();
+    conteo.ordenar(hilos);
+    Medicion medicion{segundosIngesta, 0.0, conteo.getPico(), conteo.size(), listarHeavyHitters(conteo, umbral)};
+    medicion.segundosConteo = segundosDesde(inicio);
+    return medicion;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        OpcionesEjecucion opciones = leerOpciones(argc, argv);
+        int maxHilos = (opciones.hilos <= 1) ? hilosDisponibles() : opciones.hilos;
+
+        vector<int> hilos_vals;
+        for (int h = 1; h < maxHilos; h *= 2) hilos_vals.push_back(h);
+        hilos_vals.push_back(maxHilos);
+
+        LectorGenomas lector(opciones.entrada, opciones.modoLectura, opciones.lecturaAnticipada,
+                             opciones.calidadMinima);
+
+        vector<pair<int, double>> configuraciones = {{21, 2e-6}, {31, 4e-6}};
+        for (const auto& configuracion : configuraciones) {
+            int k = configuracion.first;
+            double phi = configuracion.second;
+
+            // total de k-mers para fijar el umbral, como en ground_truth
+            vector<long long> kmersPorHilo(maxHilos, 0);
+            ingestarEnParalelo(lector, k, maxHilos, [&](int h, const uint64_t*, size_t n) {
+                kmersPorHilo[h] += n;
+            });
+            long long totalKmers = 0;
+            for (long long n : kmersPorHilo) totalKmers += n;
+            long long umbral = (long long)(phi * totalKmers);
+            cout << "\n=== " << k << "-mers: " << totalKmers << " k-mers, umbral " << umbral << " ===" << endl;
+
+            string archivocsv = "results_calibracion/comparacion_conteo_exacto_" + to_string(k) + "mer.csv";
+            ofstream out(archivocsv);
+            out << "motor,k,hilos,segundos_ingesta,segundos_conteo,segundos,mkmers_por_segundo,"
+                << "memoria_pico_bytes,distintos,heavy_hitters\n";
+
+            for (int hilos : hilos_vals) {
+                Medicion tabla = medirTabla(lector, k, hilos, umbral);
+                Medicion orden = medirOrden(lector, k, hilos, umbral);
+
+                for (const auto& par : {make_pair("tabla", &tabla), make_pair("orden", &orden)}) {
+                    const Medicion& m = *par.second;
+                    double segundos = m.segundosIngesta + m.segundosConteo;
+                    out << par.first << "," << k << "," << hilos << "," << m.segundosIngesta << ","
+                        << m.segundosConteo << "," << segundos << "," << totalKmers / segundos / 1e6 << ","
+                        << m.memoriaPico << "," << m.distintos << "," << m.heavyHitters.size() << "\n";
+                    cout << "[hilos=" << hilos << "] " << par.first << ": " << m.segundosIngesta << "s ingesta + "
+                         << m.segundosConteo << "s conteo (" << totalKmers / segundos / 1e6 << " Mk-mers/s), "
+                         << m.memoriaPico / (1024 * 1024) << " MiB, " << m.distintos << " distintos, "
+                         << m.heavyHitters.size() << " HH" << endl;
+                }
+                if (tabla.distintos != orden.distintos || tabla.heavyHitters != orden.heavyHitters) {
+                    throw runtime_error("Los motores de conteo no coinciden para " + to_string(k) + "-mers");
+                }
+            }
+
+            out.close();
+            cout << "Resultados guardados en " << archivocsv << endl;
+        }
+
+    } catch (const std::exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
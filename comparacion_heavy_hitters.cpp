@@ -0,0 +1,156 @@
+#include "sketchs/countsketch.hpp"
+#include "sketchs/towersketch.hpp"
+#include "sketchs/spacesaving.hpp"
+#include "sketchs/candidatosheavyhitters.hpp"
+#include "utils/LectorGenomas.hpp"
+#include "utils/MetricasEvaluacion.hpp"
+#include "utils/OpcionesEjecucion.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+/**
+ * Comparación de CountSketch, TowerSketch y Space-Saving para encontrar heavy hitters
+ *
+ * Cada estructura se llena en su propia pasada secuencial por los genomas, con los mismos
+ * parámetros que calcular_cs, calcular_ts y calcular_ss. Los sketches necesitan además
+ * los CandidatosHeavyHitters para listar los heavy hitters; Space-Saving los entrega
+ * directamente. Se mide el tiempo de la pasada (y descontando una pasada que solo extrae
+ * los k-mers), la memoria y precision/recall/F1 con MetricasEvaluacion contra el ground
+ * truth de CSV/ground_truth_<k>mers.csv, que debe generarse antes con ground_truth.
+ */
+
+struct Medicion {
+    string estructura;
+    size_t memoria;
+    double segundos;
+    vector<pair<string, int>> heavyHitters;
+};
+
+// Lee los heavy hitters reales (rank,kmer,real_frequency,...) guardados por ground_truth
+vector<pair<string, int>> cargarGroundTruth(const string& archivo) {
+    ifstream in(archivo);
+    if (!in.is_open()) {
+        throw runtime_error("No se pudo abrir " + archivo + "; ejecuta ground_truth primero");
+    }
+    vector<pair<string, int>> reales;
+    string linea;
+    getline(in, linea); // header
+    while (getline(in, linea)) {
+        stringstream ss(linea);
+        string rank, kmer, frecuencia;
+        if (getline(ss, rank, ',') && getline(ss, kmer, ',') && getline(ss, frecuencia, ',')) {
+            reales.emplace_back(kmer, stoi(frecuencia));
+        }
+    }
+    return reales;
+}
+
+// Solo extrae los k-mers; retorna los segundos y cuenta el total
+double medirExtraccion(LectorGenomas& lector, int k, long long& total) {
+    auto inicio = chrono::steady_clock::now();
+    vector<uint64_t> lote(LectorGenomas::TAMANO_LOTE);
+    size_t n;
+    total = 0;
+    lector.reset();
+    while ((n = lector.getNextCanonicalKmers(k, lote.data(), lote.size())) > 0) {
+        total += n;
+    }
+    return chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+}
+
+// Sketch más candidatos en línea, como calcular_cs y calcular_ts
+template <typename SketchType>
+Medicion medirSketch(const string& nombre, LectorGenomas& lector, int k, double phi, int umbral, SketchType sketch) {
+    auto inicio = chrono::steady_clock::now();
+    CandidatosHeavyHitters candidatos(phi);
+    vector<uint64_t> lote(LectorGenomas::TAMANO_LOTE);
+    size_t n;
+    lector.reset();
+    while ((n = lector.getNextCanonicalKmers(k, lote.data(), lote.size())) > 0) {
+        candidatos.insertarEn(sketch, lote.data(), n);
+    }
+    Medicion medicion{nombre, sketch.getSize() + candidatos.getSize(), 0.0, {}};
+    for (uint64_t kmer : candidatos.getCandidatos()) {
+        int estimado = sketch.estimate(kmer);
+        if (estimado >= umbral) medicion.heavyHitters.emplace_back(decodificarKmer(kmer, k), estimado);
+    }
+    medicion.segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    return medicion;
+}
+
+Medicion medirSpaceSaving(LectorGenomas& lector, int k, double phi, int umbral) {
+    auto inicio = chrono::steady_clock::now();
+    SpaceSaving resumen(SpaceSaving::capacidadPara(phi));
+    vector<uint64_t> lote(LectorGenomas::TAMANO_LOTE);
+    size_t n;
+    lector.reset();
+    while ((n = lector.getNextCanonicalKmers(k, lote.data(), lote.size())) > 0) {
+        resumen.insertBatch(lote.data(), n);
+    }
+    Medicion medicion{"spacesaving", resumen.getSize(), 0.0, {}};
+    for (const SpaceSaving::Frecuente& f : resumen.getFrecuentes(umbral)) {
+        medicion.heavyHitters.emplace_back(decodificarKmer(f.kmer, k), f.cuenta);
+    }
+    medicion.segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    return medicion;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        OpcionesEjecucion opciones = leerOpciones(argc, argv);
+        LectorGenomas lector(opciones.entrada, opciones.modoLectura, opciones.lecturaAnticipada,
+                             opciones.calidadMinima);
+        MetricasEvaluacion metricas;
+
+        vector<pair<int, double>> configuraciones = {{21, 2e-6}, {31, 4e-6}};
+        for (const auto& configuracion : configuraciones) {
+            int k = configuracion.first;
+            double phi = configuracion.second;
+            vector<pair<string, int>> reales = cargarGroundTruth("CSV/ground_truth_" + to_string(k) + "mers.csv");
+
+            long long totalKmers;
+            double segundosExtraccion = medirExtraccion(lector, k, totalKmers);
+            int umbral = static_cast<int>(phi * totalKmers);
+            cout << "\n=== " << k << "-mers: " << totalKmers << " k-mers, umbral " << umbral
+                 << ", " << reales.size() << " heavy hitters reales ===" << endl;
+            cout << "Solo extracción: " << segundosExtraccion << "s" << endl;
+
+            vector<Medicion> mediciones;
+            mediciones.push_back(medirSketch("countsketch", lector, k, phi, umbral, CountSketch(7, 35000)));
+            mediciones.push_back(medirSketch("towersketch", lector, k, phi, umbral, TowerSketch(7, 123, 7, 1, 7, 1)));
+            mediciones.push_back(medirSpaceSaving(lector, k, phi, umbral));
+
+            string archivocsv = "results_calibracion/comparacion_heavy_hitters_" + to_string(k) + "mer.csv";
+            ofstream out(archivocsv);
+            out << "estructura,k,phi,memoria_bytes,segundos,segundos_sin_extraccion,mkmers_por_segundo,"
+                << "heavy_hitters,precision,recall,f1_score\n";
+
+            for (const Medicion& m : mediciones) {
+                auto resultado = metricas.evaluarHeavyHitters(m.heavyHitters, reales, umbral, umbral);
+                double sinExtraccion = max(0.0, m.segundos - segundosExtraccion);
+                out << m.estructura << "," << k << "," << phi << "," << m.memoria << "," << m.segundos << ","
+                    << sinExtraccion << "," << totalKmers / m.segundos / 1e6 << "," << m.heavyHitters.size() << ","
+                    << resultado.precision << "," << resultado.recall << "," << resultado.f1_score << "\n";
+
+                cout << m.estructura << ": " << m.segundos << "s (" << totalKmers / m.segundos / 1e6
+                     << " Mk-mers/s), " << m.memoria / 1024 << " KiB, " << m.heavyHitters.size()
+                     << " HH, precision " << resultado.precision << ", recall " << resultado.recall
+                     << ", F1 " << resultado.f1_score << endl;
+            }
+
+            out.close();
+            cout << "Resultados guardados en " << archivocsv << endl;
+        }
+
+    } catch (const std::exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,275 @@
+#include "sketchs/countsketch.hpp"
+#include "sketchs/towersketch.hpp"
+#include "sketchs/archivosketch.hpp"
+#include "utils/ColaAcotada.hpp"
+#include "utils/IngestaParalela.hpp"
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Consultas de frecuencia contra un sketch guardado (ver sketchs/archivosketch.hpp)
+ *
+ * El sketch se abre mapeado y se comparte, de solo lectura, entre todos los hilos. Los k-mers
+ * se leen de un archivo o de la entrada estándar, uno por línea, y por cada uno se escribe
+ * "kmer<TAB>estimación" en el mismo orden. Un hilo lee la entrada en bloques de texto de hasta
+ * TAMANO_BLOQUE bytes cortados en un fin de línea y los reparte por turno a los hilos
+ * consultores; cada uno pasa sus líneas a k-mers canónicos empaquetados, los estima con
+ * estimateBatch y arma su texto de salida. Una consulta con bases distintas de ACGT no puede
+ * estar en el sketch (la ingesta corta los k-mers en esas bases), así que se responde con 0. El hilo principal recoge los bloques con el mismo turno, así que
+ * los escribe en el orden en que se leyeron sin tener que reordenarlos.
+ *
+ * Al final informa por la salida de error las consultas por segundo de punta a punta (lectura,
+ * conversión y escritura incluidas) y las del sketch solo: la suma sobre los hilos de las
+ * consultas por segundo que cada uno logra dentro de estimateBatch.
+ */
+
+static const size_t TAMANO_BLOQUE = 1 << 20;
+static const size_t BLOQUES_EN_COLA = 4;   // por hilo consultor
+
+struct BloqueConsultas {
+    string texto;       // líneas completas de la entrada
+    string salida;      // una línea "kmer\testimación" por cada línea no vacía de texto
+};
+
+using ColaBloques = ColaAcotada<shared_ptr<BloqueConsultas>>;
+
+struct ResultadoConsultas {
+    size_t consultas = 0;
+    double segundos = 0.0;
+    double consultasPorSegundoSketch = 0.0;
+};
+
+void mostrarUsoConsultar(const string& programa) {
+    cout << "Uso: " << programa << " SKETCH [--consultas RUTA|-] [--salida RUTA|-] [--hilos N]" << endl;
+}
+
+// Reparte la entrada por turno, en bloques terminados en fin de línea, entre las colas de los consultores
+void leerBloques(FILE* entrada, vector<unique_ptr<ColaBloques>>& colas) {
+    vector<char> buffer(TAMANO_BLOQUE);
+    string resto;
+    size_t turno = 0;
+    auto repartir = [&](shared_ptr<BloqueConsultas> bloque) {
+        return colas[turno++ % colas.size()]->push(std::move(bloque));
+    };
+    size_t leidos;
+    while ((leidos = fread(buffer.data(), 1, buffer.size(), entrada)) > 0) {
+        shared_ptr<BloqueConsultas> bloque = make_shared<BloqueConsultas>();
+        bloque->texto.swap(resto);
+        bloque->texto.append(buffer.data(), leidos);
+        size_t fin = bloque->texto.rfind('\n');
+        if (fin == string::npos) {
+            resto.swap(bloque->texto);  // una línea más larga que el bloque: se sigue acumulando
+            continue;
+        }
+        resto.assign(bloque->texto, fin + 1, string::npos);
+        bloque->texto.resize(fin + 1);
+        if (!repartir(std::move(bloque))) return;
+    }
+    if (ferror(entrada)) {
+        throw runtime_error("Error leyendo las consultas");
+    }
+    if (!resto.empty()) {
+        shared_ptr<BloqueConsultas> bloque = make_shared<BloqueConsultas>();
+        bloque->texto.swap(resto);
+        repartir(std::move(bloque));
+    }
+}
+
+template <typename SketchType>
+ResultadoConsultas consultar(const SketchType& sketch, int k, FILE* entrada, FILE* salida, int hilos) {
+    using Estimacion = decltype(sketch.estimate(uint64_t()));
+    auto inicio = chrono::steady_clock::now();
+
+    vector<unique_ptr<ColaBloques>> colasEntrada, colasSalida;
+    for (int h = 0; h < hilos; h++) {
+        colasEntrada.emplace_back(new ColaBloques(BLOQUES_EN_COLA));
+        colasSalida.emplace_back(new ColaBloques(BLOQUES_EN_COLA));
+    }
+    vector<size_t> consultas(hilos, 0);
+    vector<size_t> estimadas(hilos, 0);     // consultas que llegaron al sketch
+    vector<double> segundosSketch(hilos, 0.0);
+    vector<exception_ptr> errores(hilos + 1);
+
+    vector<thread> trabajadores;
+    for (int h = 0; h < hilos; h++) {
+        trabajadores.emplace_back([&, h]() {
+            try {
+                vector<uint64_t> claves;
+                vector<Estimacion> estimaciones;
+                vector<pair<size_t, size_t>> lineas;    // inicio y largo de cada consulta en el texto
+                vector<bool> validas;                   // consultas solo con ACGT, que tienen clave
+                string kmer;
+                uint64_t codigo;
+                shared_ptr<BloqueConsultas> bloque;
+                while (colasEntrada[h]->pop(bloque)) {
+                    const string& texto = bloque->texto;
+                    claves.clear();
+                    lineas.clear();
+                    validas.clear();
+                    for (size_t i = 0; i < texto.size();) {
+                        size_t fin = texto.find('\n', i);
+                        if (fin == string::npos) fin = texto.size();
+                        size_t largo = fin - i;
+                        if (largo > 0 && texto[i + largo - 1] == '\r') largo--;
+                        if (largo > 0) {
+                            kmer.assign(texto, i, largo);
+                            if (k > 0 && largo != (size_t)k) {
+                                throw runtime_error("La consulta " + kmer + " no tiene " + to_string(k) + " bases");
+                            }
+                            bool valida = codificarKmer(kmer, codigo);
+                            if (valida) claves.push_back(canonicoKmer(codigo, (int)largo));
+                            lineas.emplace_back(i, largo);
+                            validas.push_back(valida);
+                        }
+                        i = fin + 1;
+                    }
+
+                    estimaciones.resize(claves.size());
+                    auto inicioSketch = chrono::steady_clock::now();
+                    sketch.estimateBatch(claves.data(), claves.size(), estimaciones.data());
+                    segundosSketch[h] += chrono::duration<double>(chrono::steady_clock::now() - inicioSketch).count();
+                    consultas[h] += lineas.size();
+                    estimadas[h] += claves.size();
+
+                    string& textoSalida = bloque->salida;
+                    textoSalida.reserve(texto.size() + 12 * lineas.size());
+                    char numero[24];
+                    for (size_t c = 0, j = 0; c < lineas.size(); c++) {
+                        textoSalida.append(texto, lineas[c].first, lineas[c].second);
+                        textoSalida.push_back('\t');
+                        long long estimacion = validas[c] ? (long long)estimaciones[j++] : 0;
+                        char* finNumero = to_chars(numero, numero + sizeof(numero), estimacion).ptr;
+                        textoSalida.append(numero, finNumero);
+                        textoSalida.push_back('\n');
+                    }
+                    bloque->texto = string();
+                    if (!colasSalida[h]->push(std::move(bloque))) break;
+                }
+            } catch (...) {
+                errores[h] = current_exception();
+                colasEntrada[h]->cerrar(); // el lector deja de esperarlo
+            }
+            colasSalida[h]->cerrar();
+        });
+    }
+    thread lector([&]() {
+        try {
+            leerBloques(entrada, colasEntrada);
+        } catch (...) {
+            errores[hilos] = current_exception();
+        }
+        for (auto& cola : colasEntrada) cola->cerrar();
+    });
+
+    // los bloques vuelven por el mismo turno en que se repartieron, es decir, en orden
+    bool escrito = true;
+    shared_ptr<BloqueConsultas> bloque;
+    for (size_t turno = 0; escrito && colasSalida[turno % hilos]->pop(bloque); turno++) {
+        escrito = fwrite(bloque->salida.data(), 1, bloque->salida.size(), salida) == bloque->salida.size();
+    }
+    escrito = (fflush(salida) == 0) && escrito;
+    for (auto& cola : colasEntrada) cola->cerrar();
+    for (auto& cola : colasSalida) cola->cerrar();
+    lector.join();
+    for (thread& t : trabajadores) t.join();
+    for (exception_ptr& e : errores) {
+        if (e) rethrow_exception(e);
+    }
+    if (!escrito) {
+        throw runtime_error("Error escribiendo las estimaciones");
+    }
+
+    ResultadoConsultas resultado;
+    resultado.segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    for (int h = 0; h < hilos; h++) {
+        resultado.consultas += consultas[h];
+        if (segundosSketch[h] > 0.0) resultado.consultasPorSegundoSketch += estimadas[h] / segundosSketch[h];
+    }
+    return resultado;
+}
+
+int main(int argc, char* argv[]) {
+    FILE* entrada = stdin;
+    FILE* salida = stdout;
+    try {
+        if (argc < 2 || string(argv[1]).rfind("--", 0) == 0) {
+            mostrarUsoConsultar(argv[0]);
+            return 1;
+        }
+        string rutaSketch = argv[1];
+        string rutaConsultas = "-", rutaSalida = "-";
+        int hilos = 1;
+        for (int i = 2; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--consultas" && i + 1 < argc) {
+                rutaConsultas = argv[++i];
+            } else if (arg == "--salida" && i + 1 < argc) {
+                rutaSalida = argv[++i];
+            } else if (arg == "--hilos" && i + 1 < argc) {
+                hilos = stoi(argv[++i]);
+                if (hilos < 0) {
+                    throw invalid_argument("--hilos debe ser >= 0");
+                }
+            } else {
+                mostrarUsoConsultar(argv[0]);
+                throw invalid_argument("Opción desconocida: " + arg);
+            }
+        }
+        if (hilos == 0) hilos = hilosDisponibles();
+
+        if (rutaConsultas != "-" && (entrada = fopen(rutaConsultas.c_str(), "rb")) == nullptr) {
+            throw runtime_error("No se pudo abrir el archivo de consultas: " + rutaConsultas);
+        }
+        if (rutaSalida != "-" && (salida = fopen(rutaSalida.c_str(), "wb")) == nullptr) {
+            throw runtime_error("No se pudo crear el archivo de salida: " + rutaSalida);
+        }
+
+        // las estadísticas van a la salida de error para no mezclarse con las estimaciones
+        auto inicio = chrono::steady_clock::now();
+        LectorSketch lector(rutaSketch);
+        const TipoSketch tipo = lector.getTipo();
+        const int k = lector.getK();
+        ResultadoConsultas resultado;
+        auto atender = [&](const auto& sketch) {
+            cerr << "Sketch " << nombreTipoSketch(tipo);
+            if (k > 0) cerr << " de " << k << "-mers";
+            cerr << " cargado en " << chrono::duration<double>(chrono::steady_clock::now() - inicio).count()
+                 << "s; consultando con " << hilos << " hilos" << endl;
+            resultado = consultar(sketch, k, entrada, salida, hilos);
+        };
+        switch (tipo) {
+            case TipoSketch::CountSketch: atender(CountSketch::load(lector)); break;
+            case TipoSketch::CountMinCU8: atender(CountMinCU<uint8_t>::load(lector)); break;
+            case TipoSketch::CountMinCU16: atender(CountMinCU<uint16_t>::load(lector)); break;
+            case TipoSketch::CountMinCU32: atender(CountMinCU<uint32_t>::load(lector)); break;
+            case TipoSketch::TowerSketch: atender(TowerSketch::load(lector)); break;
+            default: throw runtime_error("Tipo de sketch desconocido en " + rutaSketch);
+        }
+
+        cerr << "Consultas: " << resultado.consultas << " en " << resultado.segundos << "s, "
+             << resultado.consultas / resultado.segundos << " consultas/s de punta a punta, "
+             << resultado.consultasPorSegundoSketch << " consultas/s en el sketch" << endl;
+
+    } catch (const std::exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        if (entrada != stdin) fclose(entrada);
+        if (salida != stdout) fclose(salida);
+        return 1;
+    }
+
+    if (entrada != stdin) fclose(entrada);
+    if (salida != stdout && fclose(salida) != 0) {
+        cerr << "Error: no se pudo cerrar el archivo de salida" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include "sketchs/countsketch.hpp"
+#include "sketchs/countsketchconcurrente.hpp"
+#include "utils/LectorGenomas.hpp"
+#include "utils/IngestaParalela.hpp"
+#include "utils/OpcionesEjecucion.hpp"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+/**
+ * Escalamiento de la ingesta paralela de 1 a N hilos
+ *
+ * Compara dos formas de llenar un CountSketch con varios hilos:
+ *   - replicas:   cada hilo llena su propio CountSketch y al final se combinan con merge
+ *                 (memoria = hilos * d * w contadores)
+ *   - compartido: todos los hilos insertan en un CountSketchConcurrente con contadores
+ *                 atómicos (memoria = d * w contadores, pero con contención)
+ * Se prueba una tabla chica, que cabe en caché y donde domina la contención por las mismas
+ * líneas, y una grande, donde domina la latencia de memoria.
+ */
+
+struct Medicion {
+    double segundos;
+    long long kmers;
+};
+
+// Llena una réplica por hilo y las combina; incluye el tiempo del merge
+Medicion medirReplicas(LectorGenomas& lector, int k, int hilos, CountSketch& resultado) {
+    auto inicio = chrono::steady_clock::now();
+    vector<CountSketch> replicas(hilos, resultado);
+    vector<long long> kmersPorHilo(hilos, 0);
+    ingestarEnParalelo(lector, k, hilos, [&](int h, const uint64_t* kmers, size_t n) {
+        replicas[h].insertBatch(kmers, n);
+        kmersPorHilo[h] += n;
+    });
+    long long total = 0;
+    for (int h = 0; h < hilos; h++) {
+        resultado.merge(replicas[h]);
+        total += kmersPorHilo[h];
+    }
+    return {chrono::duration<double>(chrono::steady_clock::now() - inicio).count(), total};
+}
+
+// Todos los hilos insertan en el mismo sketch atómico
+Medicion medirCompartido(LectorGenomas& lector, int k, int hilos, CountSketchConcurrente& sketch) {
+    auto inicio = chrono::steady_clock::now();
+    vector<long long> kmersPorHilo(hilos, 0);
+    ingestarEnParalelo(lector, k, hilos, [&](int h, const uint64_t* kmers, size_t n) {
+        sketch.insertBatch(kmers, n);
+        kmersPorHilo[h] += n;
+    });
+    long long total = 0;
+    for (long long n : kmersPorHilo) total += n;
+    return {chrono::duration<double>(chrono::steady_clock::now() - inicio).count(), total};
+}
+
+// Cuenta cuántos de los primeros k-mers del lector tienen estimaciones distintas en ambos sketches
+size_t contarDiferencias(LectorGenomas& lector, int k, const CountSketch& replicas,
+                         const CountSketchConcurrente& compartido) {
+    vector<uint64_t> lote(LectorGenomas::TAMANO_LOTE);
+    size_t distintos = 0;
+    lector.reset();
+    for (int i = 0; i < 16; i++) {
+        size_t n = lector.getNextCanonicalKmers(k, lote.data(), lote.size());
+        for (size_t j = 0; j < n; j++) {
+            if (replicas.estimate(lote[j]) != compartido.estimate(lote[j])) distintos++;
+        }
+    }
+    return distintos;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        OpcionesEjecucion opciones = leerOpciones(argc, argv);
+        int maxHilos = (opciones.hilos <= 1) ? hilosDisponibles() : opciones.hilos;
+
+        int k = 31;
+        int d = 7;
+        vector<int> w_vals = {35000, 4000000};
+
+        vector<int> hilos_vals;
+        for (int h = 1; h < maxHilos; h *= 2) hilos_vals.push_back(h);
+        hilos_vals.push_back(maxHilos);
+
+        LectorGenomas lector(opciones.entrada, opciones.modoLectura, opciones.lecturaAnticipada,
+                             opciones.calidadMinima);
+
+        string archivocsv = "results_calibracion/escalamiento_countsketch_" + to_string(k) + "mer.csv";
+        ofstream out(archivocsv);
+        out << "modo,hilos,d,w,memoria_bytes,segundos,mkmers_por_segundo,aceleracion\n";
+
+        for (int w : w_vals) {
+            double baseReplicas = 0.0, baseCompartido = 0.0;
+            for (int hilos : hilos_vals) {
+                CountSketch replicas(d, w);
+                Medicion mr = medirReplicas(lector, k, hilos, replicas);
+                CountSketchConcurrente compartido(d, w);
+                Medicion mc = medirCompartido(lector, k, hilos, compartido);
+
+                if (hilos == 1) {
+                    baseReplicas = mr.segundos;
+                    baseCompartido = mc.segundos;
+                }
+                size_t memoriaReplicas = (size_t)hilos * d * w * sizeof(int);
+                size_t memoriaCompartido = compartido.getSize();
+
+                out << "replicas," << hilos << "," << d << "," << w << "," << memoriaReplicas << ","
+                    << mr.segundos << "," << mr.kmers / mr.segundos / 1e6 << "," << baseReplicas / mr.segundos << "\n";
+                out << "compartido," << hilos << "," << d << "," << w << "," << memoriaCompartido << ","
+                    << mc.segundos << "," << mc.kmers / mc.segundos / 1e6 << "," << baseCompartido / mc.segundos << "\n";
+
+                cout << "[w=" << w << ", hilos=" << hilos << "] replicas: " << mr.segundos << "s ("
+                     << mr.kmers / mr.segundos / 1e6 << " Mk-mers/s, x" << baseReplicas / mr.segundos << ")"
+                     << " | compartido: " << mc.segundos << "s (" << mc.kmers / mc.segundos / 1e6
+                     << " Mk-mers/s, x" << baseCompartido / mc.segundos << ")" << endl;
+
+                if (opciones.verificar) {
+                    cout << "  Estimaciones distintas entre ambos modos: "
+                         << contarDiferencias(lector, k, replicas, compartido) << endl;
+                }
+            }
+        }
+
+        out.close();
+        cout << "Resultados guardados en " << archivocsv << endl;
+
+    } catch (const std::exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
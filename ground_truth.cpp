@@ -1,112 +1,175 @@
 #include "utils/LectorGenomas.hpp"
-#include <unordered_map>
+#include "utils/OpcionesEjecucion.hpp"
+#include "utils/ParticionMinimizadores.hpp"
+#include "sketchs/hyperloglog.hpp"
+#include "sketchs/contadorexacto.hpp"
+#include "sketchs/contadorordenado.hpp"
+#include "utils/IngestaParalela.hpp"
 #include <iostream>
 #include <chrono>
 #include <algorithm>
 #include <fstream>
 #include <iomanip>
 
-std::string getCanonicalKmer(const std::string& kmer) {
-    std::string revComp = kmer;
-    
-    // Crear complemento reverso
-    for (char& c : revComp) {
-        switch(c) {
-            case 'A': c = 'T'; break;
-            case 'T': c = 'A'; break;
-            case 'C': c = 'G'; break;
-            case 'G': c = 'C'; break;
-        }
+// Lo que se acumula al recorrer las cuentas exactas de un k (completas o de una partición)
+struct ResumenConteo {
+    size_t distintos = 0;
+    std::vector<HyperLogLog> hll;                                   // una por precisión
+    std::vector<std::pair<uint64_t, uint32_t>> heavyHitters;       // cuenta >= umbral
+
+    explicit ResumenConteo(const std::vector<int>& precisiones) {
+        for (int p : precisiones) hll.emplace_back(p);
+    }
+
+    // Conteo es ContadorExacto o ContadorOrdenado (ya ordenado)
+    template<typename Conteo>
+    void agregar(const Conteo& conteo, int umbral) {
+        distintos += conteo.size();
+        conteo.paraCada([&](uint64_t kmer, uint32_t cuenta) {
+            for (HyperLogLog& h : hll) h.insert(kmer);
+            if ((long long)cuenta >= umbral) heavyHitters.emplace_back(kmer, cuenta);
+        });
     }
-    std::reverse(revComp.begin(), revComp.end());
-    
-    // Retornar el lexicográficamente menor
-    return std::min(kmer, revComp);
-}
 
-int main(){
+    // las particiones no comparten k-mers, así que basta con sumar y unir
+    void merge(const ResumenConteo& otro) {
+        distintos += otro.distintos;
+        for (size_t j = 0; j < hll.size(); j++) hll[j].merge(otro.hll[j]);
+        heavyHitters.insert(heavyHitters.end(), otro.heavyHitters.begin(), otro.heavyHitters.end());
+    }
+};
+
+int main(int argc, char* argv[]){
     try {
+        OpcionesEjecucion opciones = leerOpciones(argc, argv);
         std::cout << "=== Extracción de Ground Truth para Heavy Hitters ===" << std::endl;
         
-        LectorGenomas reader("Genomas");
-        std::unordered_map<std::string, int> k21mers;
-        std::unordered_map<std::string, int> k31mers;
-        
-        // Estadísticas
-        long long totalKmers21 = 0;
-        long long totalKmers31 = 0;
-        
-        do {
-            reader.reset();
-            while (reader.hasMoreKmers(21)) {
-                std::string kmer = reader.getNextKmer(21);
-                if (!kmer.empty()) {
-                    bool validKmer = true;
-                    for (char c : kmer) {
-                        if (c != 'A' && c != 'T' && c != 'C' && c != 'G') {
-                            validKmer = false;
-                            break;
-                        }
-                    }
-                    
-                    if (validKmer) {
-                        std::string canonical = getCanonicalKmer(kmer);
-                        k21mers[canonical]++;
-                        totalKmers21++;
-                    }
+        LectorGenomas reader(opciones.entrada, opciones.modoLectura, opciones.lecturaAnticipada,
+                             opciones.calidadMinima);
+        
+        //HHϕ = { x ∈ U : f(x) ≥ ϕ N } donde N es el total de k-mers canónicos (incluyendo repetidos)
+        
+        // Definir ϕ (ej: 10^-3 a 10^-5) 
+        double phi_21 = 2e-6;
+        double phi_31 = 4e-6;  
+        
+        std::vector<int> ks = {21, 31};
+        std::vector<double> phis = {phi_21, phi_31};
+        long long totales[2] = {0, 0};
+        
+        // HyperLogLog de varias precisiones, para comparar su cardinalidad con la exacta
+        std::vector<int> precisiones = {10, 12, 14, 16};
+        std::vector<ResumenConteo> resumenes(ks.size(), ResumenConteo(precisiones));
+        
+        if (opciones.particiones > 0) {
+            // Fase 1: super-k-mers a disco, repartidos por minimizador
+            int hilos = (opciones.hilos == 0) ? hilosDisponibles() : opciones.hilos;
+            ParticionMinimizadores particion(ks, opciones.particiones, opciones.directorioTemporal);
+            std::cout << "Repartiendo los k-mers en " << opciones.particiones << " particiones por k en "
+                      << opciones.directorioTemporal << " con " << hilos << " hilos" << std::endl;
+            particion.distribuir(reader, hilos);
+            
+            // Fase 2: cada partición se cuenta por separado, una por hilo a la vez
+            for (size_t i = 0; i < ks.size(); i++) {
+                totales[i] = particion.getTotal(i);
+                int umbral = (int)(phis[i] * totales[i]);
+                std::vector<ResumenConteo> porHilo(hilos, ResumenConteo(precisiones));
+                std::vector<size_t> mayorPorHilo(hilos, 0);
+                particion.contar(i, hilos, [&](int h, const ContadorExacto& conteo) {
+                    porHilo[h].agregar(conteo, umbral);
+                    mayorPorHilo[h] = std::max(mayorPorHilo[h], conteo.getSize());
+                });
+                for (int h = 0; h < hilos; h++) resumenes[i].merge(porHilo[h]);
+                std::cout << ks[i] << "-mers: " << particion.getBytes(i) / (1024 * 1024) << " MiB en disco, "
+                          << "partición más grande " << *std::max_element(mayorPorHilo.begin(), mayorPorHilo.end()) / (1024 * 1024)
+                          << " MiB en memoria" << std::endl;
+            }
+        } else if (opciones.conteoOrdenado) {
+            // Conteo exacto en memoria ordenando todas las apariciones (ver ContadorOrdenado)
+            int hilos = (opciones.hilos == 0) ? hilosDisponibles() : opciones.hilos;
+            std::vector<ContadorOrdenado> conteos;
+            for (int k : ks) conteos.emplace_back(k, hilos);
+            if (hilos > 1) {
+                ingestarEnParalelo(reader, ks, hilos, [&](int h, size_t i, const uint64_t* kmers, size_t n) {
+                    conteos[i].insertBatch(h, kmers, n);
+                });
+            } else {
+                std::vector<uint64_t> lote21(LectorGenomas::TAMANO_LOTE), lote31(LectorGenomas::TAMANO_LOTE);
+                uint64_t* lotes[2] = {lote21.data(), lote31.data()};
+                size_t n[2];
+                while (reader.getNextCanonicalKmers(ks, lotes, n, LectorGenomas::TAMANO_LOTE) > 0) {
+                    conteos[0].insertBatch(lote21.data(), n[0]);
+                    conteos[1].insertBatch(lote31.data(), n[1]);
                 }
             }
             
-            // Extraer k-mers de longitud 31
-            reader.reset(); // Reiniciar posición para este archivo
-            while (reader.hasMoreKmers(31)) {
-                std::string kmer = reader.getNextKmer(31);
-                if (!kmer.empty()) {
-                    bool validKmer = true;
-                    for (char c : kmer) {
-                        if (c != 'A' && c != 'T' && c != 'C' && c != 'G') {
-                            validKmer = false;
-                            break;
-                        }
-                    }
-                    
-                    if (validKmer) {
-                        std::string canonical = getCanonicalKmer(kmer);
-                        k31mers[canonical]++;
-                        totalKmers31++;
-                    }
-                }
+            // se ordena un k a la vez y se libera antes del siguiente
+            for (size_t i = 0; i < ks.size(); i++) {
+                totales[i] = conteos[i].getTotal();
+                conteos[i].ordenar(hilos);
+                std::cout << ks[i] << "-mers ordenados con " << hilos << " hilos, memoria máxima "
+                          << conteos[i].getPico() / (1024 * 1024) << " MiB" << std::endl;
+                resumenes[i].agregar(conteos[i], (int)(phis[i] * totales[i]));
+                conteos[i] = ContadorOrdenado(ks[i]);
             }
-        } while (reader.nextFile());
+        } else {
+            // Conteo exacto en memoria, en tablas planas de 12 bytes por celda (ver ContadorExacto)
+            ContadorExacto k21mers;
+            ContadorExacto k31mers;
+            
+            // 21-mers y 31-mers en una sola pasada por los genomas
+            std::vector<uint64_t> lote21(LectorGenomas::TAMANO_LOTE), lote31(LectorGenomas::TAMANO_LOTE);
+            uint64_t* lotes[2] = {lote21.data(), lote31.data()};
+            size_t n[2];
+            while (reader.getNextCanonicalKmers(ks, lotes, n, LectorGenomas::TAMANO_LOTE) > 0) {
+                k21mers.insertBatch(lote21.data(), n[0]);
+                k31mers.insertBatch(lote31.data(), n[1]);
+                totales[0] += n[0];
+                totales[1] += n[1];
+            }
+            std::cout << "Memoria de conteo: " << (k21mers.getSize() + k31mers.getSize()) / (1024 * 1024) << " MiB ("
+                      << std::fixed << std::setprecision(1)
+                      << (double)(k21mers.getSize() + k31mers.getSize()) / std::max<size_t>(1, k21mers.size() + k31mers.size())
+                      << " bytes por k-mer distinto)" << std::endl;
+            std::cout.unsetf(std::ios::fixed);
+            std::cout << std::setprecision(6);
+            
+            resumenes[0].agregar(k21mers, (int)(phi_21 * totales[0]));
+            resumenes[1].agregar(k31mers, (int)(phi_31 * totales[1]));
+        }
+        long long totalKmers21 = totales[0];
+        long long totalKmers31 = totales[1];
         
         std::cout << "\n=== Estadísticas del procesamiento ===" << std::endl;
-        std::cout << "Total 21-mers únicos: " << k21mers.size() << std::endl;
-        std::cout << "Total 31-mers únicos: " << k31mers.size() << std::endl;
+        std::cout << "Total 21-mers únicos: " << resumenes[0].distintos << std::endl;
+        std::cout << "Total 31-mers únicos: " << resumenes[1].distintos << std::endl;
         std::cout << "Total 21-mers procesados: " << totalKmers21 << std::endl;
         std::cout << "Total 31-mers procesados: " << totalKmers31 << std::endl;
         
-        //HHϕ = { x ∈ U : f(x) ≥ ϕ N } donde N es el total de k-mers canónicos (incluyendo repetidos)
-        
-        // Definir ϕ (ej: 10^-3 a 10^-5) 
-        double phi_21 = 2e-6;
-        double phi_31 = 4e-6;  
+        // Error de HyperLogLog contra la cantidad exacta de k-mers distintos
+        std::string csvCardinalidad = "results_calibracion/cardinalidad_hyperloglog.csv";
+        std::ofstream cardinalidadOut(csvCardinalidad);
+        cardinalidadOut << "k,precision,memoria_bytes,exacto,estimado,error_relativo,error_esperado\n";
+        std::cout << "\n=== Cardinalidad con HyperLogLog ===" << std::endl;
+        for (size_t j = 0; j < precisiones.size(); j++) {
+            for (size_t i = 0; i < ks.size(); i++) {
+                const HyperLogLog& hll = resumenes[i].hll[j];
+                size_t exacto = resumenes[i].distintos;
+                double estimado = hll.estimate();
+                double error = (exacto > 0) ? (estimado - (double)exacto) / (double)exacto : 0.0;
+                cardinalidadOut << ks[i] << "," << hll.getPrecision() << "," << hll.getSize() << "," << exacto << ","
+                                << (long long)std::llround(estimado) << "," << error << "," << hll.errorEstandar() << "\n";
+                std::cout << ks[i] << "-mers, p=" << hll.getPrecision() << " (" << hll.getSize() << " bytes): "
+                          << (long long)std::llround(estimado) << " distintos estimados, error "
+                          << 100 * error << "% (esperado " << 100 * hll.errorEstandar() << "%)" << std::endl;
+            }
+        }
+        cardinalidadOut.close();
+        std::cout << "Guardado en: " << csvCardinalidad << std::endl;
         
         // Calcular umbrales: f(e) ≥ ϕN
         int k21mersBoundary = (int)(phi_21 * totalKmers21);
         int k31mersBoundary = (int)(phi_31 * totalKmers31);
-        
-        std::vector<int> frequencies21, frequencies31;
-        
-        for (const auto& kv : k21mers) {
-            frequencies21.push_back(kv.second);
-        }
-        for (const auto& kv : k31mers) {
-            frequencies31.push_back(kv.second);
-        }
-        
-        // Ordenar para obtener estadísticas
-        std::sort(frequencies21.begin(), frequencies21.end(), std::greater<int>());
-        std::sort(frequencies31.begin(), frequencies31.end(), std::greater<int>());
                 
         std::cout << "\n=== Configuración de umbrales (Definición formal) ===" << std::endl;
         std::cout << "Fórmula: HHϕ = { x ∈ U : f(x) ≥ ϕ N }" << std::endl;
@@ -118,33 +181,20 @@ int main(){
         std::vector<std::pair<std::string, int>> heavyHitters21;
         std::vector<std::pair<std::string, int>> heavyHitters31;
         
-        for (const auto& kv : k21mers) {
-            if (kv.second >= k21mersBoundary) {
-                heavyHitters21.emplace_back(kv.first, kv.second);
-            }
+        for (const auto& kv : resumenes[0].heavyHitters) {
+            heavyHitters21.emplace_back(decodificarKmer(kv.first, 21), (int)kv.second);
         }
-        for (const auto& kv : k31mers) {
-            if (kv.second >= k31mersBoundary) {
-                heavyHitters31.emplace_back(kv.first, kv.second);
-            }
+        for (const auto& kv : resumenes[1].heavyHitters) {
+            heavyHitters31.emplace_back(decodificarKmer(kv.first, 31), (int)kv.second);
         }
         
-        // Ordenar por frecuencia de mayor a menor
-        std::sort(heavyHitters21.begin(), heavyHitters21.end(),
-                 [](const auto& a, const auto& b) { return a.second > b.second; });
-        std::sort(heavyHitters31.begin(), heavyHitters31.end(),
-                 [](const auto& a, const auto& b) { return a.second > b.second; });
-        
-        int threshold31 = (int)(phi_21 * totalKmers31);
-        int threshold21 = (int)(phi_31 * totalKmers21);
-        int count21 = 0, count31 = 0;
-
-        for (const auto& kv : k21mers) {
-            if (kv.second >= threshold21) count21++;
-        }
-        for (const auto& kv : k31mers) {
-            if (kv.second >= threshold31) count31++;
-        }
+        // Ordenar por frecuencia de mayor a menor; los empates por k-mer, para que el CSV no
+        // dependa del orden de las tablas ni de las particiones
+        auto masFrecuente = [](const auto& a, const auto& b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        };
+        std::sort(heavyHitters21.begin(), heavyHitters21.end(), masFrecuente);
+        std::sort(heavyHitters31.begin(), heavyHitters31.end(), masFrecuente);
         
         std::cout << "\n=== GROUND TRUTH: Heavy Hitters ===" << std::endl;
         std::cout << "21-mers heavy hitters: " << heavyHitters21.size() << std::endl;
@@ -0,0 +1,275 @@
+#ifndef ARCHIVO_SKETCH_H
+#define ARCHIVO_SKETCH_H
+
+#include "tablacontadores.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Formato binario con que se guardan y cargan los sketches (save/load de CountSketch,
+ * CountMinCU y TowerSketch)
+ *
+ *   CabeceraArchivoSketch (64 bytes): "KMSKETCH", versión, marca de orden de bytes, tipo de
+ *       sketch, esquema de hash, k de los k-mers insertados, número de tablas y número de
+ *       réplicas combinadas en el sketch (ver TowerSketch::merge)
+ *   CabeceraTablaSketch por tabla (40 bytes): filas, columnas, paso, semilla, bytes por
+ *       contador y desplazamiento de sus contadores
+ *   los contadores de cada tabla tal como están en TablaContadores (filas x paso, con el
+ *       relleno), empezando en un múltiplo de 64 bytes
+ *
+ * Como los contadores quedan alineados y con el mismo paso que en memoria, LectorSketch
+ * puede mapear el archivo y entregar tablas que los usan en su lugar, sin leerlos ni
+ * copiarlos: abrir un sketch de varios GB toma lo mismo que uno chico y las páginas se cargan
+ * al consultarlas. El mapa es privado, así que modificar un sketch cargado copia solo las
+ * páginas tocadas y nunca cambia el archivo. Los enteros van en el orden de bytes de la
+ * máquina; un archivo escrito con el otro orden se rechaza.
+ */
+
+enum class TipoSketch : uint32_t {
+    CountSketch = 1,
+    CountMinCU8 = 2,
+    CountMinCU16 = 3,
+    CountMinCU32 = 4,
+    TowerSketch = 5
+};
+
+inline const char *nombreTipoSketch(TipoSketch tipo) {
+    switch (tipo) {
+        case TipoSketch::CountSketch: return "CountSketch";
+        case TipoSketch::CountMinCU8: return "CountMinCU<uint8_t>";
+        case TipoSketch::CountMinCU16: return "CountMinCU<uint16_t>";
+        case TipoSketch::CountMinCU32: return "CountMinCU<uint32_t>";
+        case TipoSketch::TowerSketch: return "TowerSketch";
+    }
+    return "desconocido";
+}
+
+struct CabeceraArchivoSketch {
+    static const uint32_t VERSION = 1;
+    static const uint32_t ORDEN_BYTES = 0x01020304;
+    // 1: HashFilas (dos mixhash64 por clave, columnas por reducción multiplicativa) sobre
+    //    k-mers canónicos empaquetados; cambia si cambia la forma de hashear
+    static const uint32_t ESQUEMA_HASH = 1;
+
+    char magia[8];
+    uint32_t version;
+    uint32_t ordenBytes;
+    uint32_t tipo;
+    uint32_t esquemaHash;
+    int32_t k;              // 0 si no se indicó
+    uint32_t tablas;
+    uint32_t replicas;      // sketches combinados con merge; 0 en archivos anteriores, que cuenta como 1
+    uint8_t reservado[28];
+};
+static_assert(sizeof(CabeceraArchivoSketch) == 64, "CabeceraArchivoSketch debe ocupar 64 bytes");
+
+struct CabeceraTablaSketch {
+    int32_t filas;
+    int32_t columnas;
+    uint64_t paso;
+    uint64_t semilla;
+    uint32_t bytesContador;
+    uint32_t reservado;
+    uint64_t desplazamiento; // desde el inicio del archivo, múltiplo de 64
+};
+static_assert(sizeof(CabeceraTablaSketch) == 40, "CabeceraTablaSketch debe ocupar 40 bytes");
+
+/**
+ * Arma un archivo de sketch con una o más tablas y lo escribe de una vez
+ * Se escribe a ruta + ".tmp" y se renombra al final, así que nunca queda un archivo a medias.
+ */
+class EscritorSketch
+{
+private:
+    CabeceraArchivoSketch cabecera;
+    std::vector<CabeceraTablaSketch> tablas;
+    std::vector<const void*> contadores;
+
+    static uint64_t alinear(uint64_t x) {
+        const uint64_t linea = 64;
+        return (x + linea - 1) / linea * linea;
+    }
+
+public:
+    EscritorSketch(TipoSketch tipo, int k) {
+        std::memset(&cabecera, 0, sizeof(cabecera));
+        std::memcpy(cabecera.magia, "KMSKETCH", 8);
+        cabecera.version = CabeceraArchivoSketch::VERSION;
+        cabecera.ordenBytes = CabeceraArchivoSketch::ORDEN_BYTES;
+        cabecera.tipo = (uint32_t)tipo;
+        cabecera.esquemaHash = CabeceraArchivoSketch::ESQUEMA_HASH;
+        cabecera.k = k;
+        cabecera.replicas = 1;
+    }
+
+    void setReplicas(uint32_t replicas) { cabecera.replicas = replicas; }
+
+    // La tabla debe seguir viva hasta escribir()
+    template<typename T>
+    void agregarTabla(const TablaContadores<T> &tabla, uint64_t semilla) {
+        CabeceraTablaSketch t;
+        std::memset(&t, 0, sizeof(t));
+        t.filas = tabla.getFilas();
+        t.columnas = tabla.getColumnas();
+        t.paso = tabla.getPaso();
+        t.semilla = semilla;
+        t.bytesContador = sizeof(T);
+        tablas.push_back(t);
+        contadores.push_back(tabla.fila(0));
+    }
+
+    void escribir(const std::string &ruta) {
+        cabecera.tablas = (uint32_t)tablas.size();
+        uint64_t desplazamiento = alinear(sizeof(cabecera) + tablas.size() * sizeof(CabeceraTablaSketch));
+        for (CabeceraTablaSketch &t : tablas) {
+            t.desplazamiento = desplazamiento;
+            desplazamiento = alinear(desplazamiento + (uint64_t)t.filas * t.paso * t.bytesContador);
+        }
+
+        const std::string temporal = ruta + ".tmp";
+        FILE *f = std::fopen(temporal.c_str(), "wb");
+        if (f == nullptr) {
+            throw std::runtime_error("No se pudo crear el archivo de sketch: " + ruta);
+        }
+        bool ok = std::fwrite(&cabecera, sizeof(cabecera), 1, f) == 1;
+        if (!tablas.empty()) {
+            ok = ok && std::fwrite(tablas.data(), sizeof(CabeceraTablaSketch), tablas.size(), f) == tablas.size();
+        }
+        for (size_t i = 0; i < tablas.size() && ok; i++) {
+            const CabeceraTablaSketch &t = tablas[i];
+            ok = std::fseek(f, (long)t.desplazamiento, SEEK_SET) == 0;
+            size_t bytes = (size_t)t.filas * t.paso * t.bytesContador;
+            ok = ok && std::fwrite(contadores[i], 1, bytes, f) == bytes;
+        }
+        ok = (std::fclose(f) == 0) && ok;
+        if (!ok || std::rename(temporal.c_str(), ruta.c_str()) != 0) {
+            std::remove(temporal.c_str());
+            throw std::runtime_error("Error escribiendo el archivo de sketch: " + ruta);
+        }
+    }
+};
+
+/**
+ * Abre y valida un archivo de sketch
+ * Con mapear = true el archivo se mapea y tabla() entrega vistas sobre el mapa (que vive
+ * mientras viva alguna tabla); si no, tabla() lee los contadores a memoria propia.
+ */
+class LectorSketch
+{
+private:
+    std::string ruta;
+    CabeceraArchivoSketch cabecera;
+    std::vector<CabeceraTablaSketch> tablas;
+    std::shared_ptr<void> mapa;
+    int fd;
+
+    [[noreturn]] void invalido(const std::string &motivo) const {
+        throw std::runtime_error("Archivo de sketch inválido (" + motivo + "): " + ruta);
+    }
+
+    void leerEn(void *destino, size_t bytes, uint64_t desplazamiento) const {
+        char *p = static_cast<char*>(destino);
+        while (bytes > 0) {
+            ssize_t leidos = pread(fd, p, bytes, (off_t)desplazamiento);
+            if (leidos <= 0) invalido("truncado");
+            p += leidos;
+            bytes -= (size_t)leidos;
+            desplazamiento += (uint64_t)leidos;
+        }
+    }
+
+public:
+    explicit LectorSketch(const std::string &ruta, bool mapear = true) : ruta(ruta), fd(-1) {
+        fd = open(ruta.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("No se pudo abrir el archivo de sketch: " + ruta);
+        }
+        try {
+            struct stat info;
+            if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) invalido("no es un archivo regular");
+            const uint64_t largo = (uint64_t)info.st_size;
+            if (largo < sizeof(cabecera)) invalido("truncado");
+            leerEn(&cabecera, sizeof(cabecera), 0);
+            if (std::memcmp(cabecera.magia, "KMSKETCH", 8) != 0) invalido("no es un sketch");
+            if (cabecera.ordenBytes != CabeceraArchivoSketch::ORDEN_BYTES) invalido("otro orden de bytes");
+            if (cabecera.version != CabeceraArchivoSketch::VERSION) {
+                invalido("versión " + std::to_string(cabecera.version) + " no soportada");
+            }
+            if (cabecera.esquemaHash != CabeceraArchivoSketch::ESQUEMA_HASH) invalido("otro esquema de hash");
+
+            const uint64_t finCabeceras = sizeof(cabecera) + (uint64_t)cabecera.tablas * sizeof(CabeceraTablaSketch);
+            if (cabecera.tablas > 16 || finCabeceras > largo) invalido("truncado");
+            tablas.resize(cabecera.tablas);
+            if (!tablas.empty()) leerEn(tablas.data(), tablas.size() * sizeof(CabeceraTablaSketch), sizeof(cabecera));
+            for (const CabeceraTablaSketch &t : tablas) {
+                if (t.filas <= 0 || t.columnas <= 0 || t.desplazamiento % 64 != 0 || t.paso < (uint64_t)t.columnas) {
+                    invalido("tabla mal formada");
+                }
+                uint64_t bytes = (uint64_t)t.filas * t.paso * t.bytesContador;
+                if (t.desplazamiento < finCabeceras || t.desplazamiento + bytes > largo) invalido("truncado");
+            }
+
+            if (mapear) {
+                // privado y escribible: consultar comparte las páginas del archivo, modificar las copia
+                void *p = mmap(nullptr, largo, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED) {
+                    throw std::runtime_error("Falló mmap del archivo de sketch: " + ruta);
+                }
+                mapa = std::shared_ptr<void>(p, [largo](void *q) { munmap(q, largo); });
+            }
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+    }
+
+    LectorSketch(const LectorSketch&) = delete;
+    LectorSketch &operator=(const LectorSketch&) = delete;
+
+    ~LectorSketch() {
+        close(fd);
+    }
+
+    TipoSketch getTipo() const { return (TipoSketch)cabecera.tipo; }
+    int getK() const { return cabecera.k; }
+    uint32_t getVersion() const { return cabecera.version; }
+    uint32_t getReplicas() const { return cabecera.replicas == 0 ? 1 : cabecera.replicas; }
+    size_t getTablas() const { return tablas.size(); }
+    const CabeceraTablaSketch &getTabla(size_t i) const { return tablas.at(i); }
+    bool mapeado() const { return (bool)mapa; }
+
+    // Lanza si el archivo no guarda un sketch del tipo dado con esa cantidad de tablas
+    void validar(TipoSketch tipo, size_t numTablas) const {
+        if (getTipo() != tipo || tablas.size() != numTablas) {
+            throw std::runtime_error(std::string("El archivo ") + ruta + " guarda un " + nombreTipoSketch(getTipo())
+                                     + ", no un " + nombreTipoSketch(tipo));
+        }
+    }
+
+    // Contadores de la tabla i, mapeados o leídos según el modo del lector
+    template<typename T>
+    TablaContadores<T> tabla(size_t i) const {
+        const CabeceraTablaSketch &t = tablas.at(i);
+        if (t.bytesContador != sizeof(T) || t.paso != TablaContadores<T>::pasoPara(t.columnas)) {
+            invalido("contadores de otro tamaño");
+        }
+        if (mapa) {
+            T *datos = reinterpret_cast<T*>(static_cast<char*>(mapa.get()) + t.desplazamiento);
+            return TablaContadores<T>(t.filas, t.columnas, datos, mapa);
+        }
+        TablaContadores<T> leida(t.filas, t.columnas);
+        leerEn(leida.fila(0), (size_t)t.filas * t.paso * sizeof(T), t.desplazamiento);
+        return leida;
+    }
+};
+
+#endif // ARCHIVO_SKETCH_H
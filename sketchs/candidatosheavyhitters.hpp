@@ -0,0 +1,152 @@
+#ifndef CANDIDATOS_HEAVY_HITTERS_H
+#define CANDIDATOS_HEAVY_HITTERS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Candidatos a heavy hitter mantenidos en línea junto a un sketch
+ *
+ * Se mira la estimación de cada k-mer recién insertado y se guardan solo los que alcanzan
+ * fraccion·φ·N, con N los k-mers vistos hasta ese momento. Si el sketch nunca subestima
+ * (CountMinCU y TowerSketch), un heavy hitter (f ≥ φ·N al final) supera ese umbral a más
+ * tardar en su última aparición, así que queda entre los candidatos. Con un CountSketch no
+ * hay esa garantía: la mediana puede quedar bajo la frecuencia real y un heavy hitter cerca
+ * del umbral puede no entrar nunca. Como a lo más 1/(fraccion·φ) k-mers
+ * pueden superar el umbral a la vez, la tabla se limita a capacidad = 2/(fraccion·φ)
+ * entradas: al llenarse se descartan los que quedaron bajo el umbral actual y, si aún no
+ * alcanza, los de menor estimación hasta quedar en la mitad. La memoria es O(1/φ) en vez
+ * de O(k-mers distintos). Al final las frecuencias se vuelven a estimar en el sketch.
+ *
+ * insertarEn() inserta y toma la estimación en la misma pasada (insertBatch con
+ * estimaciones), leyendo los contadores que la actualización ya trajo a caché: cuesta poco
+ * más que la inserción sola. actualizar() sobre un sketch ya lleno vuelve a hashear y
+ * consultar cada k-mer con estimateBatch, lo que puede costar tanto como la inserción.
+ */
+class CandidatosHeavyHitters
+{
+private:
+    double phi;
+    double fraccion;
+    size_t capacidad;
+    long long total;                                // k-mers vistos (N)
+    std::unordered_map<uint64_t, int> candidatos;   // k-mer -> última estimación vista
+    std::vector<int> estimaciones;                  // de un lote, para insertarEn y actualizar
+
+    double umbral() const {
+        return std::max(1.0, fraccion * phi * (double)total);
+    }
+
+    // deja la tabla en a lo más capacidad / 2 entradas
+    void podar() {
+        const double u = umbral();
+        for (auto it = candidatos.begin(); it != candidatos.end();) {
+            it = (it->second < u) ? candidatos.erase(it) : std::next(it);
+        }
+        size_t objetivo = capacidad / 2;
+        if (candidatos.size() <= objetivo) return;
+
+        // menor estimación que se conserva
+        std::vector<int> estimaciones;
+        estimaciones.reserve(candidatos.size());
+        for (const auto &kv : candidatos) estimaciones.push_back(kv.second);
+        size_t corte = estimaciones.size() - objetivo;
+        std::nth_element(estimaciones.begin(), estimaciones.begin() + corte, estimaciones.end());
+        int minimo = estimaciones[corte];
+
+        for (auto it = candidatos.begin(); it != candidatos.end();) {
+            it = (it->second < minimo) ? candidatos.erase(it) : std::next(it);
+        }
+        // empates en el mínimo
+        for (auto it = candidatos.begin(); it != candidatos.end() && candidatos.size() > objetivo;) {
+            it = (it->second == minimo) ? candidatos.erase(it) : std::next(it);
+        }
+    }
+
+public:
+    /**
+     * @param phi Fracción de N que define un heavy hitter
+     * @param fraccion Fracción de φ·N desde la que un k-mer pasa a ser candidato
+     */
+    CandidatosHeavyHitters(double phi, double fraccion = 0.5)
+        : phi(phi), fraccion(fraccion), total(0) {
+        if (phi <= 0 || phi >= 1 || fraccion <= 0 || fraccion > 1) {
+            throw std::invalid_argument("Parámetros de CandidatosHeavyHitters invalidos");
+        }
+        capacidad = (size_t)std::ceil(2.0 / (fraccion * phi));
+    }
+
+    /**
+     * Registra n k-mers recién insertados con sus estimaciones
+     * @param estimaciones Estimación de cada k-mer en el sketch después de insertarlo
+     */
+    void actualizar(const uint64_t *kmers, const int *estimaciones, size_t n) {
+        total += (long long)n;
+        const double u = umbral();
+        for (size_t i = 0; i < n; i++) {
+            if (estimaciones[i] >= u) {
+                candidatos[kmers[i]] = estimaciones[i];
+            }
+        }
+        if (candidatos.size() > capacidad) podar();
+    }
+
+    /**
+     * Inserta n k-mers en el sketch y los registra con la estimación que deja cada inserción
+     * @param sketch Sketch con insertBatch(kmers, n, estimaciones), como CountSketch y TowerSketch
+     */
+    template<typename Sketch>
+    void insertarEn(Sketch &sketch, const uint64_t *kmers, size_t n) {
+        if (estimaciones.size() < n) estimaciones.resize(n);
+        sketch.insertBatch(kmers, n, estimaciones.data());
+        actualizar(kmers, estimaciones.data(), n);
+    }
+
+    /**
+     * Registra n k-mers ya insertados en el sketch, estimándolos de nuevo con estimateBatch
+     * @param sketch Sketch que ya contiene los k-mers
+     */
+    template<typename Sketch>
+    void actualizar(const Sketch &sketch, const uint64_t *kmers, size_t n) {
+        if (estimaciones.size() < n) estimaciones.resize(n);
+        sketch.estimateBatch(kmers, n, estimaciones.data());
+        actualizar(kmers, estimaciones.data(), n);
+    }
+
+    /**
+     * Une los candidatos de otra réplica (ingesta paralela)
+     * No poda: las estimaciones guardadas son de réplicas parciales, así que deben
+     * volver a estimarse en el sketch combinado antes de compararlas con φ·N.
+     */
+    void merge(const CandidatosHeavyHitters &otro) {
+        for (const auto &kv : otro.candidatos) {
+            int &estimado = candidatos[kv.first];
+            estimado = std::max(estimado, kv.second);
+        }
+        total += otro.total;
+    }
+
+    // k-mers candidatos, para estimar su frecuencia final en el sketch
+    std::vector<uint64_t> getCandidatos() const {
+        std::vector<uint64_t> kmers;
+        kmers.reserve(candidatos.size());
+        for (const auto &kv : candidatos) kmers.push_back(kv.first);
+        return kmers;
+    }
+
+    size_t size() const { return candidatos.size(); }
+    size_t getCapacidad() const { return capacidad; }
+    long long getTotal() const { return total; }
+
+    // Bytes usados; los nodos del unordered_map se estiman (clave, valor, hash y puntero)
+    size_t getSize() const {
+        return candidatos.bucket_count() * sizeof(void*)
+             + candidatos.size() * (sizeof(std::pair<const uint64_t, int>) + 2 * sizeof(void*));
+    }
+};
+
+#endif // CANDIDATOS_HEAVY_HITTERS_H
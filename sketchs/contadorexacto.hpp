@@ -0,0 +1,182 @@
+#ifndef CONTADOR_EXACTO_H
+#define CONTADOR_EXACTO_H
+
+#include "mixhash64.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * Conteo exacto de k-mers canónicos empaquetados en una tabla plana con direccionamiento abierto
+ *
+ * Cada celda guarda la clave de 64 bits y una cuenta de 32 bits empaquetadas en 12 bytes,
+ * sin nodos ni punteros como std::unordered_map (~40 bytes por k-mer, más de 80 con claves
+ * string). Una cuenta 0 marca la celda vacía, así que no hace falta reservar una clave. Las
+ * colisiones se resuelven con sondeo lineal desde mixhash64(clave), que recorre celdas
+ * contiguas de la misma línea de caché. La tabla se duplica al superar CARGA_MAXIMA, de modo
+ * que la memoria queda entre 12 / CARGA_MAXIMA y 24 / CARGA_MAXIMA bytes por k-mer distinto
+ * (15 a 30 bytes), según cuán llena quedó la última duplicación. Mientras se duplica conviven
+ * la tabla anterior y la nueva, tres veces la anterior; reservar() con el total esperado evita
+ * las duplicaciones y ese pico. Las cuentas saturan en 2^32 - 1.
+ */
+class ContadorExacto
+{
+private:
+    struct __attribute__((packed)) Celda {
+        uint64_t clave;
+        uint32_t cuenta;
+    };
+    static_assert(sizeof(Celda) == 12, "Celda debe ocupar 12 bytes");
+
+    uint64_t semilla;
+    std::vector<Celda> celdas;
+    size_t mascara;     // celdas.size() - 1, potencia de 2
+    size_t ocupadas;
+    size_t limite;      // ocupadas que gatillan la siguiente duplicación
+
+    size_t posicion(uint64_t kmer) const {
+        return (size_t)mixhash64(kmer, semilla) & mascara;
+    }
+
+    void sumarEn(size_t i, uint64_t kmer, uint32_t cantidad) {
+        while (true) {
+            Celda &c = celdas[i];
+            if (c.cuenta == 0) {
+                c.clave = kmer;
+                c.cuenta = cantidad;
+                ocupadas++;
+                return;
+            }
+            if (c.clave == kmer) {
+                c.cuenta = (c.cuenta > UINT32_MAX - cantidad) ? UINT32_MAX : c.cuenta + cantidad;
+                return;
+            }
+            i = (i + 1) & mascara;
+        }
+    }
+
+    void redimensionar(size_t numCeldas) {
+        std::vector<Celda> anteriores;
+        anteriores.swap(celdas);
+        celdas.assign(numCeldas, Celda{0, 0});
+        mascara = numCeldas - 1;
+        limite = (size_t)(numCeldas * CARGA_MAXIMA);
+        ocupadas = 0;
+        for (const Celda &c : anteriores) {
+            if (c.cuenta != 0) sumarEn(posicion(c.clave), c.clave, c.cuenta);
+        }
+    }
+
+    static size_t celdasPara(size_t distintos) {
+        size_t numCeldas = 16;
+        while (numCeldas * CARGA_MAXIMA < distintos) numCeldas *= 2;
+        return numCeldas;
+    }
+
+public:
+    static constexpr double CARGA_MAXIMA = 0.8;
+    static const int VENTANA_PREFETCH = 8; // k-mers hasheados por adelantado en insertBatch
+
+    /**
+     * @param distintos K-mers distintos esperados; la tabla crece sola si se superan
+     */
+    explicit ContadorExacto(size_t distintos = 0, uint64_t semilla = 0)
+        : semilla(semilla), mascara(0), ocupadas(0), limite(0) {
+        redimensionar(celdasPara(distintos));
+    }
+
+    // Prepara la tabla para al menos distintos k-mers sin volver a crecer
+    void reservar(size_t distintos) {
+        size_t numCeldas = celdasPara(distintos);
+        if (numCeldas > celdas.size()) redimensionar(numCeldas);
+    }
+
+    // Suma una aparición de un k-mer canónico empaquetado
+    void insert(uint64_t kmer) {
+        if (ocupadas >= limite) redimensionar(celdas.size() * 2);
+        sumarEn(posicion(kmer), kmer, 1);
+    }
+
+    /**
+     * Suma n k-mers, equivalente a insert() uno por uno
+     * Calcula la celda inicial de VENTANA_PREFETCH k-mers por adelantado y la pide con
+     * prefetch. Se avanza en tramos que no pueden llenar la tabla, para que las posiciones
+     * adelantadas sigan siendo válidas (la tabla solo crece entre tramos).
+     */
+    void insertBatch(const uint64_t *kmers, size_t n) {
+        size_t posiciones[VENTANA_PREFETCH];
+        size_t i = 0;
+        while (i < n) {
+            if (ocupadas >= limite) redimensionar(celdas.size() * 2);
+            size_t fin = i + std::min(n - i, limite - ocupadas);
+            size_t adelantados = std::min(fin, i + (size_t)VENTANA_PREFETCH);
+            for (size_t j = i; j < adelantados; j++) {
+                posiciones[j % VENTANA_PREFETCH] = posicion(kmers[j]);
+                __builtin_prefetch(&celdas[posiciones[j % VENTANA_PREFETCH]], 1);
+            }
+            for (; i < fin; i++) {
+                size_t p = posiciones[i % VENTANA_PREFETCH];
+                if (i + VENTANA_PREFETCH < fin) {
+                    size_t siguiente = posicion(kmers[i + VENTANA_PREFETCH]);
+                    posiciones[i % VENTANA_PREFETCH] = siguiente;
+                    __builtin_prefetch(&celdas[siguiente], 1);
+                }
+                sumarEn(p, kmers[i], 1);
+            }
+        }
+    }
+
+    // Cuenta exacta de un k-mer (0 si nunca apareció)
+    uint32_t estimate(uint64_t kmer) const {
+        for (size_t i = posicion(kmer);; i = (i + 1) & mascara) {
+            const Celda &c = celdas[i];
+            if (c.cuenta == 0) return 0;
+            if (c.clave == kmer) return c.cuenta;
+        }
+    }
+
+    /**
+     * Suma las cuentas de otro contador (réplicas por hilo)
+     * Recorrer la otra tabla en orden e insertar con el mismo hash en una tabla más chica
+     * forma cúmulos enormes en el sondeo lineal, así que primero se crece hasta tener al
+     * menos tantas celdas como la otra y espacio para la unión sin volver a crecer.
+     */
+    void merge(const ContadorExacto &otro) {
+        reservar(std::max(ocupadas + otro.ocupadas, (size_t)(otro.celdas.size() * CARGA_MAXIMA)));
+        for (const Celda &c : otro.celdas) {
+            if (c.cuenta == 0) continue;
+            sumarEn(posicion(c.clave), c.clave, c.cuenta);
+        }
+    }
+
+    // Llama f(kmer, cuenta) para cada k-mer distinto, en orden de la tabla
+    template<typename F>
+    void paraCada(F f) const {
+        paraCada(0, celdas.size(), f);
+    }
+
+    /**
+     * Igual que paraCada(f), solo con los k-mers de las celdas [desde, hasta)
+     * Los tramos disjuntos de [0, getCeldas()) se pueden recorrer en paralelo.
+     */
+    template<typename F>
+    void paraCada(size_t desde, size_t hasta, F f) const {
+        for (size_t i = desde; i < hasta; i++) {
+            const Celda &c = celdas[i];
+            if (c.cuenta == 0) continue;
+            uint64_t kmer = c.clave;    // copias: no se puede enlazar una referencia a un campo empaquetado
+            uint32_t cuenta = c.cuenta;
+            f(kmer, cuenta);
+        }
+    }
+
+    size_t size() const { return ocupadas; }
+    size_t getCeldas() const { return celdas.size(); }
+
+    size_t getSize() const {
+        return celdas.size() * sizeof(Celda);
+    }
+};
+
+#endif // CONTADOR_EXACTO_H
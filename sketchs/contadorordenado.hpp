@@ -0,0 +1,261 @@
+#ifndef CONTADOR_ORDENADO_H
+#define CONTADOR_ORDENADO_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/**
+ * Conteo exacto de k-mers canónicos empaquetados ordenándolos en vez de usar una tabla hash
+ *
+ * Las apariciones se acumulan tal cual en arreglos de uint64_t (uno por hilo productor, sin
+ * sincronización) y ordenar() las ordena con un radix sort paralelo: una pasada MSD reparte
+ * todo en 2^BITS_MSD cubetas según los bits altos y después cada cubeta, que cabe en caché,
+ * se termina con pasadas LSD de BITS_LSD bits que los hilos toman de a una. Solo se ordenan
+ * los 2k bits que ocupa el k-mer, y se saltan las pasadas en que todos comparten el dígito.
+ * Las cuentas salen de recorrer las corridas de claves iguales del arreglo ordenado.
+ *
+ * Todos los accesos son secuenciales o a 2^BITS_LSD destinos, pero la memoria es de 8 bytes
+ * por aparición (16 durante el reparto MSD) en vez de por k-mer distinto como en
+ * ContadorExacto: conviene cuando hay muchos núcleos y las repeticiones son pocas.
+ */
+class ContadorOrdenado
+{
+private:
+    static const int BITS_MSD = 12;
+    static const int BITS_LSD = 8;
+    static const size_t CUBETAS_MSD = (size_t)1 << BITS_MSD;
+    static const size_t DIGITOS_LSD = (size_t)1 << BITS_LSD;
+
+    int bits;                                   // 2k bits significativos por clave
+    std::vector<std::vector<uint64_t>> bloques; // apariciones sin ordenar, una lista por productor
+    std::vector<uint64_t> ordenados;
+    std::vector<size_t> inicioCubeta;           // CUBETAS_MSD + 1 posiciones en ordenados
+    size_t distintos;
+    size_t pico;
+
+    size_t bytesBloques() const {
+        size_t bytes = 0;
+        for (const std::vector<uint64_t> &b : bloques) bytes += b.capacity() * sizeof(uint64_t);
+        return bytes;
+    }
+
+    // Lanza trabajar(hilo) en hilos hilos y relanza la primera excepción
+    template<typename Trabajar>
+    static void enHilos(int hilos, Trabajar trabajar) {
+        if (hilos <= 1) {
+            trabajar(0);
+            return;
+        }
+        std::vector<std::thread> trabajadores;
+        std::vector<std::exception_ptr> errores(hilos);
+        for (int h = 0; h < hilos; h++) {
+            trabajadores.emplace_back([&, h]() {
+                try {
+                    trabajar(h);
+                } catch (...) {
+                    errores[h] = std::current_exception();
+                }
+            });
+        }
+        for (std::thread &t : trabajadores) t.join();
+        for (std::exception_ptr &e : errores) {
+            if (e) std::rethrow_exception(e);
+        }
+    }
+
+    // Llama f(clave) para las apariciones [desde, hasta) contadas a través de todos los bloques
+    template<typename F>
+    void recorrer(size_t desde, size_t hasta, F f) const {
+        size_t base = 0;
+        for (const std::vector<uint64_t> &b : bloques) {
+            size_t fin = base + b.size();
+            if (fin > desde && base < hasta) {
+                size_t i = std::max(desde, base) - base;
+                size_t j = std::min(hasta, fin) - base;
+                for (; i < j; i++) f(b[i]);
+            }
+            base = fin;
+            if (base >= hasta) break;
+        }
+    }
+
+    /**
+     * Ordena datos[0, n) por los bits [0, bitsBajos) usando aux como espacio de trabajo
+     * Un solo recorrido arma los histogramas de todas las pasadas; al final el resultado
+     * queda en datos.
+     */
+    static void ordenarLSD(uint64_t *datos, uint64_t *aux, size_t n, int bitsBajos) {
+        const int pasadas = (bitsBajos + BITS_LSD - 1) / BITS_LSD;
+        std::vector<size_t> histogramas(pasadas * DIGITOS_LSD, 0);
+        for (size_t i = 0; i < n; i++) {
+            uint64_t clave = datos[i];
+            for (int p = 0; p < pasadas; p++) {
+                histogramas[p * DIGITOS_LSD + ((clave >> (p * BITS_LSD)) & (DIGITOS_LSD - 1))]++;
+            }
+        }
+
+        uint64_t *origen = datos, *destino = aux;
+        for (int p = 0; p < pasadas; p++) {
+            size_t *cuenta = &histogramas[p * DIGITOS_LSD];
+            // si todas las claves comparten el dígito la pasada no cambia nada
+            if (cuenta[(origen[0] >> (p * BITS_LSD)) & (DIGITOS_LSD - 1)] == n) continue;
+            size_t suma = 0;
+            for (size_t d = 0; d < DIGITOS_LSD; d++) {
+                size_t c = cuenta[d];
+                cuenta[d] = suma;
+                suma += c;
+            }
+            for (size_t i = 0; i < n; i++) {
+                uint64_t clave = origen[i];
+                destino[cuenta[(clave >> (p * BITS_LSD)) & (DIGITOS_LSD - 1)]++] = clave;
+            }
+            std::swap(origen, destino);
+        }
+        if (origen != datos) std::copy(origen, origen + n, datos);
+    }
+
+public:
+    /**
+     * @param k Longitud de los k-mers (1 a 32)
+     * @param productores Hilos que insertarán a la vez, cada uno con su índice
+     */
+    explicit ContadorOrdenado(int k, int productores = 1)
+        : bits(2 * k), bloques(std::max(1, productores)), distintos(0), pico(0) {
+        if (k < 1 || k > 32) {
+            throw std::invalid_argument("k debe estar entre 1 y 32");
+        }
+    }
+
+    // Reserva espacio para apariciones del productor dado, evitando las reasignaciones del vector
+    void reservar(size_t apariciones, int productor = 0) {
+        bloques[productor].reserve(apariciones);
+    }
+
+    // Agrega n apariciones; cada productor puede llamarlo desde su propio hilo
+    void insertBatch(int productor, const uint64_t *kmers, size_t n) {
+        bloques[productor].insert(bloques[productor].end(), kmers, kmers + n);
+    }
+
+    void insertBatch(const uint64_t *kmers, size_t n) {
+        insertBatch(0, kmers, n);
+    }
+
+    /**
+     * Ordena todas las apariciones insertadas (y las de un ordenar() anterior)
+     * @param hilos Hilos para el reparto MSD y para las cubetas
+     */
+    void ordenar(int hilos) {
+        if (hilos < 1) hilos = 1;
+        if (!ordenados.empty()) {
+            // vuelve a ordenar lo anterior junto con lo nuevo
+            bloques.push_back(std::move(ordenados));
+            ordenados = std::vector<uint64_t>();
+        }
+        size_t total = 0;
+        for (const std::vector<uint64_t> &b : bloques) total += b.size();
+
+        // Reparto MSD: histograma por hilo de su tramo, luego cada hilo escribe en sus posiciones
+        const int corrimiento = std::max(0, bits - BITS_MSD);
+        std::vector<std::vector<size_t>> posiciones(hilos, std::vector<size_t>(CUBETAS_MSD, 0));
+        enHilos(hilos, [&](int h) {
+            std::vector<size_t> &cuenta = posiciones[h];
+            recorrer(total * h / hilos, total * (h + 1) / hilos, [&](uint64_t clave) {
+                cuenta[clave >> corrimiento]++;
+            });
+        });
+        inicioCubeta.assign(CUBETAS_MSD + 1, 0);
+        size_t suma = 0;
+        for (size_t c = 0; c < CUBETAS_MSD; c++) {
+            inicioCubeta[c] = suma;
+            for (int h = 0; h < hilos; h++) {
+                size_t n = posiciones[h][c];
+                posiciones[h][c] = suma;
+                suma += n;
+            }
+        }
+        inicioCubeta[CUBETAS_MSD] = suma;
+
+        ordenados.resize(total);
+        pico = std::max(pico, bytesBloques() + ordenados.capacity() * sizeof(uint64_t));
+        uint64_t *destino = ordenados.data();
+        enHilos(hilos, [&](int h) {
+            std::vector<size_t> &posicion = posiciones[h];
+            recorrer(total * h / hilos, total * (h + 1) / hilos, [&](uint64_t clave) {
+                destino[posicion[clave >> corrimiento]++] = clave;
+            });
+        });
+        bloques.assign(bloques.size(), std::vector<uint64_t>());
+
+        // Cubetas: cada hilo toma la siguiente libre, la termina con LSD y cuenta sus distintos
+        std::atomic<size_t> siguiente(0);
+        std::atomic<size_t> totalDistintos(0);
+        std::vector<size_t> mayorAuxiliar(hilos, 0);
+        enHilos(hilos, [&](int h) {
+            std::vector<uint64_t> aux;
+            size_t propios = 0;
+            size_t c;
+            while ((c = siguiente.fetch_add(1)) < CUBETAS_MSD) {
+                uint64_t *datos = destino + inicioCubeta[c];
+                size_t n = inicioCubeta[c + 1] - inicioCubeta[c];
+                if (n == 0) continue;
+                if (corrimiento > 0 && n > 1) {
+                    if (aux.size() < n) aux.resize(n);
+                    ordenarLSD(datos, aux.data(), n, corrimiento);
+                }
+                propios++;
+                for (size_t i = 1; i < n; i++) propios += (datos[i] != datos[i - 1]);
+            }
+            mayorAuxiliar[h] = aux.capacity() * sizeof(uint64_t);
+            totalDistintos += propios;
+        });
+        distintos = totalDistintos;
+        size_t auxiliares = 0;
+        for (size_t a : mayorAuxiliar) auxiliares += a;
+        pico = std::max(pico, ordenados.capacity() * sizeof(uint64_t) + auxiliares);
+    }
+
+    /**
+     * Llama f(kmer, cuenta) para cada k-mer distinto, de menor a mayor clave
+     * Solo ve lo ordenado en el último ordenar().
+     */
+    template<typename F>
+    void paraCada(F f) const {
+        const size_t n = ordenados.size();
+        size_t i = 0;
+        while (i < n) {
+            uint64_t kmer = ordenados[i];
+            size_t j = i + 1;
+            while (j < n && ordenados[j] == kmer) j++;
+            uint32_t cuenta = (j - i > UINT32_MAX) ? UINT32_MAX : (uint32_t)(j - i);
+            f(kmer, cuenta);
+            i = j;
+        }
+    }
+
+    // K-mers distintos tras el último ordenar()
+    size_t size() const { return distintos; }
+
+    // Apariciones insertadas y aún no ordenadas más las ya ordenadas
+    size_t getTotal() const {
+        size_t total = ordenados.size();
+        for (const std::vector<uint64_t> &b : bloques) total += b.size();
+        return total;
+    }
+
+    // Bytes usados ahora
+    size_t getSize() const {
+        return bytesBloques() + ordenados.capacity() * sizeof(uint64_t);
+    }
+
+    // Mayor memoria usada durante ordenar(), o la actual si es mayor
+    size_t getPico() const {
+        return std::max(pico, getSize());
+    }
+};
+
+#endif // CONTADOR_ORDENADO_H
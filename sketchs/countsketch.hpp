@@ -1,7 +1,10 @@
 #ifndef COUNT_SKETCH_H
 #define COUNT_SKETCH_H
 
-#include "murmurhash32.hpp"
+#include "mixhash64.hpp"
+#include "tablacontadores.hpp"
+#include "archivosketch.hpp"
+#include "mediana.hpp"
 #include <unordered_map>
 #include <iostream>
 #include <chrono>
@@ -16,67 +19,207 @@
 /**
  * CountSketch
  * 
+ * Las claves enteras son k-mers canónicos empaquetados en 2 bits (ver utils/CodificadorKmers.hpp);
+ * las versiones con string convierten el texto con claveKmer y dan el mismo resultado.
  */
 class CountSketch
 {
 private:
     int d,w; 
-    std::vector<std::vector<int>> tabla;
-
-    // retorna el reverso complementario de la cadena de ADN
-    std::string revComp(const std::string &s) {
-        std::string rc = s;
-        for (char &c : rc) {
-            switch(c) {
-                case 'A': c = 'T'; break;
-                case 'T': c = 'A'; break;
-                case 'C': c = 'G'; break;
-                case 'G': c = 'C'; break;
-            }
+    uint64_t semilla;
+    TablaContadores<int> tabla;
+
+    void aplicar(const HashFilas &h) {
+        for (int j = 0; j < d; j++) {
+            tabla(j, h.columna(j, w)) += h.signo(j); // actualizar la tabla
         }
-        std::reverse(rc.begin(), rc.end());
-        return rc;
     }
 
-    // retorna el k-mer canónico (lexicográficamente mínimo entre la cadena y su reverso complementario)
-    std::string canonical(const std::string &s) {
-        std::string rc = revComp(s);
-        return std::min(s, rc); // lexicográficamente mínimo
+    static int validarFilas(int d, int w) {
+        if (d <= 0 || d > D_MAX || w <= 0) {
+            throw std::invalid_argument("Dimensiones de CountSketch invalidas");
+        }
+        return d;
     }
 
+    /**
+     * Inserta n k-mers dados por su hash (hashear(i) retorna el HashFilas del i-ésimo)
+     * Hashea VENTANA_PREFETCH k-mers por adelantado, guarda las direcciones de sus
+     * contadores y las pide con prefetch, de modo que la latencia de memoria de uno
+     * se oculta detrás de las actualizaciones de los anteriores. Si estimaciones no es nulo,
+     * recibe la estimación de cada k-mer leída de los mismos contadores recién actualizados.
+     */
+    template<typename Hashear>
+    void insertarLote(size_t n, Hashear hashear, int *estimaciones = nullptr) {
+        int *pendientes[VENTANA_PREFETCH][D_MAX];
+        uint32_t signos[VENTANA_PREFETCH]; // bits de signo de HashFilas::signo
+        auto preparar = [&](size_t i) {
+            const HashFilas h = hashear(i);
+            int **p = pendientes[i % VENTANA_PREFETCH];
+            for (int j = 0; j < d; j++) {
+                p[j] = &tabla(j, h.columna(j, w));
+                __builtin_prefetch(p[j], 1);
+            }
+            signos[i % VENTANA_PREFETCH] = (uint32_t)h.h1;
+        };
+        size_t adelantados = std::min(n, (size_t)VENTANA_PREFETCH);
+        for (size_t i = 0; i < adelantados; i++) preparar(i);
+        for (size_t i = 0; i < n; i++) {
+            int **p = pendientes[i % VENTANA_PREFETCH];
+            uint32_t sg = signos[i % VENTANA_PREFETCH];
+            for (int j = 0; j < d; j++) {
+                *p[j] += ((sg >> j) & 1) ? 1 : -1;
+            }
+            if (estimaciones != nullptr) {
+                int estimates[D_MAX];
+                for (int j = 0; j < d; j++) {
+                    estimates[j] = ((sg >> j) & 1) ? *p[j] : -*p[j];
+                }
+                estimaciones[i] = medianaFilas(estimates, d);
+            }
+            if (i + VENTANA_PREFETCH < n) preparar(i + VENTANA_PREFETCH);
+        }
+    }
+
+    // sketch sobre una tabla ya llena (cargada de un archivo)
+    CountSketch(uint64_t semilla, TablaContadores<int> &&tabla)
+        : d(validarFilas(tabla.getFilas(), tabla.getColumnas())), w(tabla.getColumnas()),
+          semilla(semilla), tabla(std::move(tabla)) {}
+
 public:
+    static const int D_MAX = HashFilas::FILAS_MAX;
+    static const int VENTANA_PREFETCH = 8; // k-mers hasheados por adelantado en insertBatch y estimateBatch
+
     // Crea el countsketch con d filas y w columnas
-    CountSketch(int d, int w): d(d), w(w), tabla(d, std::vector<int>(w,0)) {};
+    // paginasGrandes pide la tabla con páginas de 2 MiB (útil para w muy grandes)
+    CountSketch(int d, int w, uint64_t semilla = 0, bool paginasGrandes = false)
+        : d(validarFilas(d, w)), w(w), semilla(semilla), tabla(d, w, paginasGrandes) {}
+
+    // Inserta un k-mer canónico empaquetado en el countsketch
+    void insert(uint64_t kmer) {
+        aplicar(HashFilas(kmer, semilla)); // un solo hash para todas las filas
+    }
+
+    // Inserta n k-mers canónicos empaquetados, equivalente a insert() uno por uno
+    void insertBatch(const uint64_t *kmers, size_t n) {
+        insertarLote(n, [&](size_t i) { return HashFilas(kmers[i], semilla); });
+    }
+
+    /**
+     * Como insertBatch(kmers, n), y deja en estimaciones[i] la estimación del i-ésimo k-mer
+     * justo después de insertarlo (la que daría estimate() en ese momento), calculada con los
+     * d contadores que ya están en caché por la actualización
+     */
+    void insertBatch(const uint64_t *kmers, size_t n, int *estimaciones) {
+        insertarLote(n, [&](size_t i) { return HashFilas(kmers[i], semilla); }, estimaciones);
+    }
+
+    /**
+     * Inserta n k-mers ya hasheados con HashFilas(kmer, getSemilla()), para reutilizar
+     * el hash entre varios sketches de la misma semilla (ver utils/MotorCalibracion.hpp)
+     */
+    void insertBatch(const HashFilas *hashes, size_t n) {
+        insertarLote(n, [&](size_t i) { return hashes[i]; });
+    }
+
+    /**
+     * Suma los contadores de otro countsketch con las mismas dimensiones y semilla
+     * El CountSketch es lineal, así que el resultado es idéntico a haber insertado
+     * en un solo sketch todos los k-mers de ambos.
+     */
+    void merge(const CountSketch &otro) {
+        if (d != otro.d || w != otro.w || semilla != otro.semilla) {
+            throw std::invalid_argument("No se pueden combinar CountSketch con distintas dimensiones o semilla");
+        }
+        for (int j = 0; j < d; j++) {
+            int *fila = tabla.fila(j);
+            const int *filaOtro = otro.tabla.fila(j);
+            for (int i = 0; i < w; i++) {
+                fila[i] += filaOtro[i];
+            }
+        }
+    }
 
     // Inserta un k-mer en el countsketch
     void insert(const std::string &kmer) {
-        std::string canon = canonical(kmer); // usar k-mer canónico
+        insert(claveKmer(kmer));
+    }
+
+    // Estima la frecuencia de un k-mer canónico empaquetado en el countsketch
+    int estimate(uint64_t kmer) const {
+        HashFilas h(kmer, semilla);
+        int estimates[D_MAX];
+
         for (int j = 0; j < d; j++) {
-            uint32_t h_j = murmurhash(canon, j) % w; // hash para la columna
-            uint32_t s_j = murmurhash(canon, j + 1000); // hash para el signo
-            int sign = (s_j & 1) ? 1 : -1; // signo basado en el hash
+            estimates[j] = h.signo(j) * tabla(j, h.columna(j, w));
+        }
+
+        // retornar la mediana de las estimaciones
+        return medianaFilas(estimates, d);
+    }
 
-            tabla[j][h_j] += sign; // actualizar la tabla
+    /**
+     * Estima n k-mers canónicos empaquetados, equivalente a estimate() uno por uno
+     * Adelanta el hash y el prefetch de VENTANA_PREFETCH k-mers como insertBatch. Solo lee
+     * la tabla, así que varios hilos pueden consultar a la vez un mismo sketch.
+     */
+    void estimateBatch(const uint64_t *kmers, size_t n, int *estimaciones) const {
+        const int *pendientes[VENTANA_PREFETCH][D_MAX];
+        uint32_t signos[VENTANA_PREFETCH];
+        auto preparar = [&](size_t i) {
+            const HashFilas h(kmers[i], semilla);
+            const int **p = pendientes[i % VENTANA_PREFETCH];
+            for (int j = 0; j < d; j++) {
+                p[j] = &tabla(j, h.columna(j, w));
+                __builtin_prefetch(p[j], 0);
+            }
+            signos[i % VENTANA_PREFETCH] = (uint32_t)h.h1;
+        };
+        size_t adelantados = std::min(n, (size_t)VENTANA_PREFETCH);
+        for (size_t i = 0; i < adelantados; i++) preparar(i);
+        for (size_t i = 0; i < n; i++) {
+            const int **p = pendientes[i % VENTANA_PREFETCH];
+            uint32_t sg = signos[i % VENTANA_PREFETCH];
+            int estimates[D_MAX];
+            for (int j = 0; j < d; j++) {
+                estimates[j] = ((sg >> j) & 1) ? *p[j] : -*p[j];
+            }
+            if (i + VENTANA_PREFETCH < n) preparar(i + VENTANA_PREFETCH);
+            estimaciones[i] = medianaFilas(estimates, d);
         }
     }
 
     // Estima la frecuencia de un k-mer en el countsketch
-    int estimate(const std::string &kmer) {
-        std::string canon = canonical(kmer); // usar k-mer canónico
-        std::vector<int> estimates; 
-        estimates.reserve(d); 
+    int estimate(const std::string &kmer) const {
+        return estimate(claveKmer(kmer));
+    }
 
-        for (int j = 0; j < d; j++) {
-            uint32_t h_j = murmurhash(canon, j) % w; // hash para la columna
-            uint32_t s_j = murmurhash(canon, j + 1000); // hash para el signo
-            int sign = (s_j & 1) ? 1 : -1; // signo basado en el hash
+    /**
+     * Guarda el sketch en el formato binario de archivosketch.hpp
+     * @param k Longitud de los k-mers insertados, para que la valide quien lo cargue (0 = sin indicar)
+     */
+    void save(const std::string &ruta, int k = 0) const {
+        EscritorSketch escritor(TipoSketch::CountSketch, k);
+        escritor.agregarTabla(tabla, semilla);
+        escritor.escribir(ruta);
+    }
 
-            estimates.push_back(sign * tabla[j][h_j]);
-        }
+    // Carga un sketch guardado con save(); con un lector mapeado los contadores quedan en el archivo
+    static CountSketch load(const LectorSketch &lector) {
+        lector.validar(TipoSketch::CountSketch, 1);
+        return CountSketch(lector.getTabla(0).semilla, lector.tabla<int>(0));
+    }
 
-        // retornar la mediana de las estimaciones
-        std::nth_element(estimates.begin(), estimates.begin() + estimates.size()/2, estimates.end());
-        return estimates[estimates.size()/2];
+    static CountSketch load(const std::string &ruta, bool mapear = true) {
+        return load(LectorSketch(ruta, mapear));
+    }
+
+    int getD() const { return d; }
+    int getW() const { return w; }
+    uint64_t getSemilla() const { return semilla; }
+
+    size_t getSize() const {
+        return (size_t)d * w * sizeof(int);
     }
 };
 
@@ -0,0 +1,145 @@
+#ifndef COUNT_SKETCH_BLOQUES_H
+#define COUNT_SKETCH_BLOQUES_H
+
+#include "mixhash64.hpp"
+#include "tablacontadores.hpp"
+#include "mediana.hpp"
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+
+/**
+ * CountSketch por bloques ("una línea de caché por clave")
+ *
+ * Usa la misma memoria que CountSketch(d, w), pero dividida en bloques de 64 bytes
+ * (16 contadores). Un hash elige el bloque de la clave y sus d contadores quedan dentro
+ * de él, en posiciones offset + j*paso (mod 16) con paso impar, que son distintas para
+ * d <= 16. Cada insert/estimate toca una sola línea de caché en vez de d. A cambio, las
+ * d estimaciones de una clave ya no son independientes entre sí (todas comparten las
+ * colisiones del bloque), lo que aumenta el error; ver calibracion_sketchs.cpp.
+ */
+class CountSketchBloques
+{
+private:
+    static const int CONTADORES_POR_BLOQUE = TablaContadores<int>::LINEA_CACHE / sizeof(int);
+
+    int d,w;
+    uint64_t semilla;
+    uint32_t bloques;
+    TablaContadores<int> tabla; // una sola fila de bloques * 16 contadores
+
+    static int validarFilas(int d, int w) {
+        if (d <= 0 || d > D_MAX || w <= 0) {
+            throw std::invalid_argument("Dimensiones de CountSketchBloques invalidas");
+        }
+        return d;
+    }
+
+    // primer contador del bloque de la clave
+    int *bloque(const HashFilas &h) {
+        return tabla.fila(0) + (size_t)(((h.h1 >> 32) * bloques) >> 32) * CONTADORES_POR_BLOQUE;
+    }
+
+    const int *bloque(const HashFilas &h) const {
+        return tabla.fila(0) + (size_t)(((h.h1 >> 32) * bloques) >> 32) * CONTADORES_POR_BLOQUE;
+    }
+
+    // posición dentro del bloque del contador de la fila j
+    static int posicion(const HashFilas &h, int j) {
+        int offset = (int)(h.h2 >> 60);
+        int paso = (int)((h.h2 >> 56) & 0xF) | 1;
+        return (offset + j * paso) & (CONTADORES_POR_BLOQUE - 1);
+    }
+
+    void aplicar(const HashFilas &h) {
+        int *b = bloque(h);
+        for (int j = 0; j < d; j++) {
+            b[posicion(h, j)] += h.signo(j);
+        }
+    }
+
+    // inserta n k-mers dados por su hash (hashear(i) retorna el HashFilas del i-ésimo)
+    template<typename Hashear>
+    void insertarLote(size_t n, Hashear hashear) {
+        HashFilas pendientes[VENTANA_PREFETCH];
+        size_t adelantados = std::min(n, (size_t)VENTANA_PREFETCH);
+        for (size_t i = 0; i < adelantados; i++) {
+            pendientes[i] = hashear(i);
+            __builtin_prefetch(bloque(pendientes[i]), 1);
+        }
+        for (size_t i = 0; i < n; i++) {
+            HashFilas &h = pendientes[i % VENTANA_PREFETCH];
+            aplicar(h);
+            if (i + VENTANA_PREFETCH < n) {
+                h = hashear(i + VENTANA_PREFETCH);
+                __builtin_prefetch(bloque(h), 1);
+            }
+        }
+    }
+
+public:
+    static const int D_MAX = CONTADORES_POR_BLOQUE;
+    static const int VENTANA_PREFETCH = 8; // k-mers hasheados por adelantado en insertBatch
+
+    // Crea el sketch con el mismo número de contadores que un CountSketch de d filas y w columnas
+    CountSketchBloques(int d, int w, uint64_t semilla = 0, bool paginasGrandes = false)
+        : d(validarFilas(d, w)), w(w), semilla(semilla),
+          bloques((uint32_t)(((size_t)d * w + CONTADORES_POR_BLOQUE - 1) / CONTADORES_POR_BLOQUE)),
+          tabla(1, bloques * CONTADORES_POR_BLOQUE, paginasGrandes) {}
+
+    // Inserta un k-mer canónico empaquetado
+    void insert(uint64_t kmer) {
+        aplicar(HashFilas(kmer, semilla));
+    }
+
+    // Inserta n k-mers con prefetch del bloque de los que vienen, igual que CountSketch::insertBatch
+    void insertBatch(const uint64_t *kmers, size_t n) {
+        insertarLote(n, [&](size_t i) { return HashFilas(kmers[i], semilla); });
+    }
+
+    // Inserta n k-mers ya hasheados con HashFilas(kmer, getSemilla())
+    void insertBatch(const HashFilas *hashes, size_t n) {
+        insertarLote(n, [&](size_t i) { return hashes[i]; });
+    }
+
+    // Suma los contadores de otro sketch con las mismas dimensiones y semilla (ver CountSketch::merge)
+    void merge(const CountSketchBloques &otro) {
+        if (d != otro.d || w != otro.w || semilla != otro.semilla) {
+            throw std::invalid_argument("No se pueden combinar CountSketchBloques con distintas dimensiones o semilla");
+        }
+        int *datos = tabla.fila(0);
+        const int *datosOtro = otro.tabla.fila(0);
+        for (size_t i = 0; i < (size_t)bloques * CONTADORES_POR_BLOQUE; i++) {
+            datos[i] += datosOtro[i];
+        }
+    }
+
+    void insert(const std::string &kmer) {
+        insert(claveKmer(kmer));
+    }
+
+    // Estima la frecuencia de un k-mer canónico empaquetado (mediana de los d contadores)
+    int estimate(uint64_t kmer) const {
+        HashFilas h(kmer, semilla);
+        const int *b = bloque(h);
+        int estimates[D_MAX];
+
+        for (int j = 0; j < d; j++) {
+            estimates[j] = h.signo(j) * b[posicion(h, j)];
+        }
+
+        return medianaFilas(estimates, d);
+    }
+
+    int estimate(const std::string &kmer) const {
+        return estimate(claveKmer(kmer));
+    }
+
+    uint64_t getSemilla() const { return semilla; }
+
+    size_t getSize() {
+        return (size_t)bloques * CONTADORES_POR_BLOQUE * sizeof(int);
+    }
+};
+
+#endif // COUNT_SKETCH_BLOQUES_H
@@ -0,0 +1,113 @@
+#ifndef COUNT_SKETCH_CONCURRENTE_H
+#define COUNT_SKETCH_CONCURRENTE_H
+
+#include "mixhash64.hpp"
+#include "tablacontadores.hpp"
+#include "mediana.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/**
+ * CountSketch compartido entre hilos
+ *
+ * Mismo hash y misma disposición que CountSketch(d, w, semilla), pero cada contador es un
+ * std::atomic<int32_t> que se actualiza con fetch_add relajado. Varios hilos pueden insertar
+ * en el mismo sketch sin candados ni réplicas, así que la memoria no crece con el número
+ * de hilos. Como la suma es conmutativa, al terminar la ingesta las estimaciones son
+ * idénticas a las de un CountSketch secuencial. El costo es la contención: cada
+ * fetch_add es una operación atómica y los hilos que tocan la misma línea de caché se la
+ * disputan (ver escalamiento_hilos.cpp).
+ *
+ * estimate() puede llamarse durante la ingesta, pero entonces cada contador refleja un
+ * instante distinto; para resultados exactos hay que leer después de que todos los hilos
+ * terminaron (por ejemplo después de join).
+ */
+class CountSketchConcurrente
+{
+private:
+    typedef std::atomic<int32_t> Contador;
+    static_assert(Contador::is_always_lock_free, "Se necesitan contadores atómicos sin candado");
+
+    int d,w;
+    uint64_t semilla;
+    TablaContadores<Contador> tabla;
+
+    void aplicar(const HashFilas &h) {
+        for (int j = 0; j < d; j++) {
+            tabla(j, h.columna(j, w)).fetch_add(h.signo(j), std::memory_order_relaxed);
+        }
+    }
+
+    static int validarFilas(int d, int w) {
+        if (d <= 0 || d > D_MAX || w <= 0) {
+            throw std::invalid_argument("Dimensiones de CountSketchConcurrente invalidas");
+        }
+        return d;
+    }
+
+public:
+    static const int D_MAX = HashFilas::FILAS_MAX;
+    static const int VENTANA_PREFETCH = 8; // k-mers hasheados por adelantado en insertBatch
+
+    CountSketchConcurrente(int d, int w, uint64_t semilla = 0, bool paginasGrandes = false)
+        : d(validarFilas(d, w)), w(w), semilla(semilla), tabla(d, w, paginasGrandes) {}
+
+    // Inserta un k-mer canónico empaquetado; seguro de llamar desde varios hilos a la vez
+    void insert(uint64_t kmer) {
+        aplicar(HashFilas(kmer, semilla));
+    }
+
+    void insert(const std::string &kmer) {
+        insert(claveKmer(kmer));
+    }
+
+    // Inserta n k-mers con prefetch de los que vienen, igual que CountSketch::insertBatch
+    void insertBatch(const uint64_t *kmers, size_t n) {
+        Contador *pendientes[VENTANA_PREFETCH][D_MAX];
+        uint32_t signos[VENTANA_PREFETCH];
+        auto preparar = [&](size_t i) {
+            HashFilas h(kmers[i], semilla);
+            Contador **p = pendientes[i % VENTANA_PREFETCH];
+            for (int j = 0; j < d; j++) {
+                p[j] = &tabla(j, h.columna(j, w));
+                __builtin_prefetch(p[j], 1);
+            }
+            signos[i % VENTANA_PREFETCH] = (uint32_t)h.h1;
+        };
+        size_t adelantados = std::min(n, (size_t)VENTANA_PREFETCH);
+        for (size_t i = 0; i < adelantados; i++) preparar(i);
+        for (size_t i = 0; i < n; i++) {
+            Contador **p = pendientes[i % VENTANA_PREFETCH];
+            uint32_t sg = signos[i % VENTANA_PREFETCH];
+            for (int j = 0; j < d; j++) {
+                p[j]->fetch_add(((sg >> j) & 1) ? 1 : -1, std::memory_order_relaxed);
+            }
+            if (i + VENTANA_PREFETCH < n) preparar(i + VENTANA_PREFETCH);
+        }
+    }
+
+    // Estima la frecuencia de un k-mer canónico empaquetado (mediana de las d filas)
+    int estimate(uint64_t kmer) const {
+        HashFilas h(kmer, semilla);
+        int estimates[D_MAX];
+
+        for (int j = 0; j < d; j++) {
+            estimates[j] = h.signo(j) * tabla(j, h.columna(j, w)).load(std::memory_order_relaxed);
+        }
+
+        return medianaFilas(estimates, d);
+    }
+
+    int estimate(const std::string &kmer) const {
+        return estimate(claveKmer(kmer));
+    }
+
+    size_t getSize() {
+        return (size_t)d * w * sizeof(Contador);
+    }
+};
+
+#endif // COUNT_SKETCH_CONCURRENTE_H
@@ -0,0 +1,50 @@
+#ifndef MEDIANA_H
+#define MEDIANA_H
+
+#include <algorithm>
+
+// deja a <= b; sobre variables locales el compilador lo resuelve con cmov, sin saltos
+inline void ordenarPar(int &a, int &b) {
+    int menor = (a < b) ? a : b;
+    int mayor = (a < b) ? b : a;
+    a = menor;
+    b = mayor;
+}
+
+/**
+ * Mediana de las d estimaciones por fila de un CountSketch: el elemento d/2 si se ordenaran,
+ * igual que std::nth_element(v, v + d/2, v + d)
+ *
+ * Para d = 3, 5 y 7, los valores usados en el proyecto, se usa una red fija de comparaciones
+ * (Devillard, "Fast median search", 1998) que el compilador traduce a min/max sin saltos; el
+ * resto cae en nth_element, que puede desordenar v.
+ */
+inline int medianaFilas(int *v, int d) {
+    switch (d) {
+        case 1:
+            return v[0];
+        case 3:
+            return std::max(std::min(v[0], v[1]), std::min(std::max(v[0], v[1]), v[2]));
+        case 5: {
+            int p0 = v[0], p1 = v[1], p2 = v[2], p3 = v[3], p4 = v[4];
+            ordenarPar(p0, p1); ordenarPar(p3, p4); ordenarPar(p0, p3);
+            ordenarPar(p1, p4); ordenarPar(p1, p2); ordenarPar(p2, p3);
+            ordenarPar(p1, p2);
+            return p2;
+        }
+        case 7: {
+            int p0 = v[0], p1 = v[1], p2 = v[2], p3 = v[3], p4 = v[4], p5 = v[5], p6 = v[6];
+            ordenarPar(p0, p5); ordenarPar(p0, p3); ordenarPar(p1, p6);
+            ordenarPar(p2, p4); ordenarPar(p0, p1); ordenarPar(p3, p5);
+            ordenarPar(p2, p6); ordenarPar(p2, p3); ordenarPar(p3, p6);
+            ordenarPar(p4, p5); ordenarPar(p1, p4); ordenarPar(p1, p3);
+            ordenarPar(p3, p4);
+            return p3;
+        }
+        default:
+            std::nth_element(v, v + d / 2, v + d);
+            return v[d / 2];
+    }
+}
+
+#endif // MEDIANA_H
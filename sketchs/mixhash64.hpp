@@ -0,0 +1,79 @@
+#ifndef MIXHASH64_H
+#define MIXHASH64_H
+
+#include "murmurhash32.hpp"
+#include "../utils/CodificadorKmers.hpp"
+#include <cstdint>
+#include <string>
+#include <algorithm>
+
+/**
+ * Mezclador de enteros de 64 bits (finalizador fmix64 de MurmurHash3) para claves de ancho fijo.
+ * La semilla se suma multiplicada por la razón áurea para que la clave 0 (AAA...A) no quede en 0.
+ */
+inline uint64_t mixhash64(uint64_t key, uint64_t seed) {
+    uint64_t h = key + (seed + 1) * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * Hashes de una clave para las d filas de un sketch.
+ * Se calculan dos mezclas de 64 bits por clave y de ellas se derivan todas las filas:
+ * la columna de la fila j sale de los 32 bits altos de h1 + j*h2 (doble hashing de
+ * Kirsch-Mitzenmacher) y el signo de la fila j del bit j de h1, que la columna no usa.
+ */
+struct HashFilas {
+    static const int FILAS_MAX = 32; // un bit de signo por fila en los 32 bits bajos de h1
+
+    uint64_t h1, h2;
+
+    HashFilas() : h1(0), h2(1) {}
+
+    HashFilas(uint64_t key, uint64_t seed)
+        : h1(mixhash64(key, seed)),
+          h2(mixhash64(key, seed + 0x51ED270B27ULL) | 1) {}
+
+    // columna de la fila j en [0, w), por reducción multiplicativa en vez de módulo
+    uint32_t columna(int j, uint32_t w) const {
+        uint64_t x = (h1 + (uint64_t)j * h2) >> 32;
+        return (uint32_t)((x * w) >> 32);
+    }
+
+    // signo (+1/-1) de la fila j
+    int signo(int j) const {
+        return ((h1 >> j) & 1) ? 1 : -1;
+    }
+};
+
+/**
+ * Convierte un k-mer de texto en la clave entera que usan los sketches.
+ * Para k <= 32 con bases ACGT es el k-mer canónico empaquetado en 2 bits, así que
+ * insert(string) e insert(uint64_t) dan exactamente el mismo resultado.
+ * Cualquier otro texto (k > 32 o bases no ACGT) se resume con dos murmurhash de su forma canónica.
+ */
+inline uint64_t claveKmer(const std::string &kmer) {
+    uint64_t codigo;
+    if (codificarKmer(kmer, codigo)) {
+        return canonicoKmer(codigo, (int)kmer.size());
+    }
+
+    std::string rc = kmer;
+    for (char &c : rc) {
+        switch(c) {
+            case 'A': c = 'T'; break;
+            case 'T': c = 'A'; break;
+            case 'C': c = 'G'; break;
+            case 'G': c = 'C'; break;
+        }
+    }
+    std::reverse(rc.begin(), rc.end());
+    const std::string &canon = std::min(kmer, rc);
+    return ((uint64_t)murmurhash(canon, 0) << 32) | murmurhash(canon, 1);
+}
+
+#endif // MIXHASH64_H
@@ -0,0 +1,303 @@
+#ifndef SPACE_SAVING_H
+#define SPACE_SAVING_H
+
+#include "mixhash64.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Space-Saving (Metwally, Agrawal y El Abbadi, 2005) sobre un stream-summary
+ *
+ * Monitorea a lo más capacidad k-mers con un contador cada uno. Un k-mer nuevo con la
+ * tabla llena reemplaza al de menor cuenta y hereda esa cuenta (+1), que queda como su
+ * error. Así cuenta - error <= f <= cuenta, el error es a lo más N/capacidad, y todo k-mer
+ * con f > N/capacidad está monitoreado: con capacidad >= 1/φ los heavy hitters salen
+ * directamente de la estructura, sin un conjunto de candidatos externo ni volver a leer
+ * los genomas. Los contadores con la misma cuenta comparten una cubeta y las cubetas
+ * forman una lista ordenada por cuenta, de modo que incrementar y encontrar el mínimo son
+ * O(1); los contadores y las cubetas viven en vectores y se enlazan por índice.
+ */
+class SpaceSaving
+{
+public:
+    // k-mer monitoreado con su cuenta y la sobreestimación máxima de esa cuenta
+    struct Frecuente {
+        uint64_t kmer;
+        int cuenta;
+        int error;
+    };
+
+private:
+    static const int NINGUNO = -1;
+
+    struct Contador {
+        uint64_t clave;
+        uint32_t cuenta;
+        uint32_t error;
+        int cubeta;
+        int anterior, siguiente;    // dentro de la cubeta
+    };
+
+    struct Cubeta {
+        uint32_t valor;
+        int primero;                // lista de contadores con cuenta == valor
+        int anterior, siguiente;    // cubetas vecinas, por valor creciente
+    };
+
+    size_t capacidad;
+    long long total;
+    std::vector<Contador> contadores;
+    std::vector<Cubeta> cubetas;
+    std::vector<int> cubetasLibres;
+    int minima;                                 // cubeta de menor valor
+    std::unordered_map<uint64_t, int> indice;   // k-mer -> contador
+
+    int nuevaCubeta(uint32_t valor, int anterior, int siguiente) {
+        int b;
+        if (cubetasLibres.empty()) {
+            b = (int)cubetas.size();
+            cubetas.push_back(Cubeta());
+        } else {
+            b = cubetasLibres.back();
+            cubetasLibres.pop_back();
+        }
+        cubetas[b] = {valor, NINGUNO, anterior, siguiente};
+        if (anterior != NINGUNO) cubetas[anterior].siguiente = b;
+        else minima = b;
+        if (siguiente != NINGUNO) cubetas[siguiente].anterior = b;
+        return b;
+    }
+
+    void liberarCubeta(int b) {
+        const Cubeta &cb = cubetas[b];
+        if (cb.anterior != NINGUNO) cubetas[cb.anterior].siguiente = cb.siguiente;
+        else minima = cb.siguiente;
+        if (cb.siguiente != NINGUNO) cubetas[cb.siguiente].anterior = cb.anterior;
+        cubetasLibres.push_back(b);
+    }
+
+    void ponerEnCubeta(int c, int b) {
+        Contador &ct = contadores[c];
+        ct.cubeta = b;
+        ct.cuenta = cubetas[b].valor;
+        ct.anterior = NINGUNO;
+        ct.siguiente = cubetas[b].primero;
+        if (ct.siguiente != NINGUNO) contadores[ct.siguiente].anterior = c;
+        cubetas[b].primero = c;
+    }
+
+    // saca el contador de su cubeta y libera la cubeta si queda vacía
+    void sacarDeCubeta(int c) {
+        const Contador &ct = contadores[c];
+        if (ct.anterior != NINGUNO) contadores[ct.anterior].siguiente = ct.siguiente;
+        else cubetas[ct.cubeta].primero = ct.siguiente;
+        if (ct.siguiente != NINGUNO) contadores[ct.siguiente].anterior = ct.anterior;
+        if (cubetas[ct.cubeta].primero == NINGUNO) liberarCubeta(ct.cubeta);
+    }
+
+    // mueve el contador a la cubeta de valor cuenta + 1
+    void incrementar(int c) {
+        int b = contadores[c].cubeta;
+        uint32_t valor = cubetas[b].valor + 1;
+        int siguiente = cubetas[b].siguiente;
+        if (siguiente != NINGUNO && cubetas[siguiente].valor == valor) {
+            sacarDeCubeta(c);
+            ponerEnCubeta(c, siguiente);
+        } else if (cubetas[b].primero == c && contadores[c].siguiente == NINGUNO) {
+            // único contador de la cubeta: basta subir su valor, el orden se mantiene
+            cubetas[b].valor = valor;
+            contadores[c].cuenta = valor;
+        } else {
+            int destino = nuevaCubeta(valor, b, siguiente);
+            sacarDeCubeta(c);
+            ponerEnCubeta(c, destino);
+        }
+    }
+
+    // menor cuenta monitoreada, o 0 si aún queda espacio
+    uint32_t minimo() const {
+        return (contadores.size() < capacidad) ? 0 : cubetas[minima].valor;
+    }
+
+    // rehace el stream-summary con los contadores dados (claves distintas, a lo más capacidad)
+    void reconstruir(std::vector<Contador> nuevos) {
+        std::sort(nuevos.begin(), nuevos.end(),
+                  [](const Contador &a, const Contador &b) { return a.cuenta < b.cuenta; });
+        contadores.clear();
+        cubetas.clear();
+        cubetasLibres.clear();
+        indice.clear();
+        minima = NINGUNO;
+        int ultima = NINGUNO;
+        for (const Contador &ct : nuevos) {
+            int c = (int)contadores.size();
+            contadores.push_back(ct);
+            if (ultima == NINGUNO || cubetas[ultima].valor != ct.cuenta) {
+                ultima = nuevaCubeta(ct.cuenta, ultima, NINGUNO);
+            }
+            ponerEnCubeta(c, ultima);
+            indice.emplace(ct.clave, c);
+        }
+    }
+
+public:
+    /**
+     * @param capacidad Contadores; el error de cada cuenta es a lo más N/capacidad
+     */
+    explicit SpaceSaving(size_t capacidad)
+        : capacidad(capacidad), total(0), minima(NINGUNO) {
+        if (capacidad == 0 || capacidad > (size_t)INT32_MAX) {
+            throw std::invalid_argument("Capacidad de SpaceSaving invalida");
+        }
+        contadores.reserve(capacidad);
+        indice.reserve(capacidad + 1);
+    }
+
+    /**
+     * Capacidad para reportar los φ-heavy hitters con una sobreestimación de a lo más
+     * fraccion·φ·N; todo k-mer con f >= φ·N queda monitoreado
+     */
+    static size_t capacidadPara(double phi, double fraccion = 0.5) {
+        if (phi <= 0 || phi >= 1 || fraccion <= 0 || fraccion > 1) {
+            throw std::invalid_argument("Parámetros de SpaceSaving invalidos");
+        }
+        return (size_t)std::ceil(1.0 / (fraccion * phi));
+    }
+
+    // Inserta un k-mer canónico empaquetado
+    void insert(uint64_t kmer) {
+        total++;
+        auto insertado = indice.try_emplace(kmer, NINGUNO);
+        if (!insertado.second) {
+            incrementar(insertado.first->second);
+            return;
+        }
+
+        int c;
+        if (contadores.size() < capacidad) {
+            c = (int)contadores.size();
+            contadores.push_back({kmer, 0, 0, NINGUNO, NINGUNO, NINGUNO});
+            int b = (minima != NINGUNO && cubetas[minima].valor == 1) ? minima : nuevaCubeta(1, NINGUNO, minima);
+            ponerEnCubeta(c, b);
+        } else {
+            // reemplaza al de menor cuenta, que hereda como error
+            c = cubetas[minima].primero;
+            indice.erase(contadores[c].clave);
+            contadores[c].clave = kmer;
+            contadores[c].error = contadores[c].cuenta;
+            incrementar(c);
+        }
+        insertado.first->second = c;
+    }
+
+    void insert(const std::string &kmer) {
+        insert(claveKmer(kmer));
+    }
+
+    // Cada inserción depende de la anterior por las cubetas, así que no hay prefetch que ganar
+    void insertBatch(const uint64_t *kmers, size_t n) {
+        for (size_t i = 0; i < n; i++) insert(kmers[i]);
+    }
+
+    /**
+     * Cota superior de la frecuencia de un k-mer
+     * Un k-mer no monitoreado puede haber aparecido a lo más minimo() veces.
+     */
+    int estimate(uint64_t kmer) const {
+        auto it = indice.find(kmer);
+        return (int)((it == indice.end()) ? minimo() : contadores[it->second].cuenta);
+    }
+
+    int estimate(const std::string &kmer) const {
+        return estimate(claveKmer(kmer));
+    }
+
+    // Sobreestimación máxima de estimate(kmer)
+    int errorMaximo(uint64_t kmer) const {
+        auto it = indice.find(kmer);
+        return (int)((it == indice.end()) ? minimo() : contadores[it->second].error);
+    }
+
+    /**
+     * Combina con otro resumen de la misma capacidad (réplicas de la ingesta paralela)
+     * Suma las cuentas, usando el mínimo del otro resumen para los k-mers que este no
+     * monitorea, y conserva los capacidad de mayor cuenta (Agarwal et al., 2012). Las
+     * garantías se mantienen con N = total de ambos, pero a diferencia del CountSketch el
+     * resultado no es idéntico al de una sola ingesta.
+     */
+    void merge(const SpaceSaving &otro) {
+        if (capacidad != otro.capacidad) {
+            throw std::invalid_argument("No se pueden combinar SpaceSaving con distinta capacidad");
+        }
+        const uint32_t minimoPropio = minimo();
+        const uint32_t minimoOtro = otro.minimo();
+
+        std::vector<Contador> combinados;
+        combinados.reserve(contadores.size() + otro.contadores.size());
+        for (const Contador &ct : contadores) {
+            auto it = otro.indice.find(ct.clave);
+            if (it == otro.indice.end()) {
+                combinados.push_back({ct.clave, ct.cuenta + minimoOtro, ct.error + minimoOtro, 0, 0, 0});
+            } else {
+                const Contador &o = otro.contadores[it->second];
+                combinados.push_back({ct.clave, ct.cuenta + o.cuenta, ct.error + o.error, 0, 0, 0});
+            }
+        }
+        for (const Contador &o : otro.contadores) {
+            if (indice.find(o.clave) == indice.end()) {
+                combinados.push_back({o.clave, o.cuenta + minimoPropio, o.error + minimoPropio, 0, 0, 0});
+            }
+        }
+
+        if (combinados.size() > capacidad) {
+            std::nth_element(combinados.begin(), combinados.begin() + capacidad, combinados.end(),
+                             [](const Contador &a, const Contador &b) { return a.cuenta > b.cuenta; });
+            combinados.resize(capacidad);
+        }
+        total += otro.total;
+        reconstruir(std::move(combinados));
+    }
+
+    /**
+     * k-mers monitoreados con cuenta >= umbral, de mayor a menor cuenta
+     * Incluye a todos los k-mers con f >= umbral si umbral > minimo(); los que además
+     * cumplen cuenta - error >= umbral son heavy hitters con certeza.
+     */
+    std::vector<Frecuente> getFrecuentes(long long umbral) const {
+        std::vector<Frecuente> frecuentes;
+        for (const Contador &ct : contadores) {
+            if (ct.cuenta >= umbral) frecuentes.push_back({ct.clave, (int)ct.cuenta, (int)ct.error});
+        }
+        std::sort(frecuentes.begin(), frecuentes.end(),
+                  [](const Frecuente &a, const Frecuente &b) { return a.cuenta > b.cuenta; });
+        return frecuentes;
+    }
+
+    // Los k k-mers de mayor cuenta
+    std::vector<Frecuente> getTopK(size_t k) const {
+        std::vector<Frecuente> frecuentes = getFrecuentes(0);
+        if (frecuentes.size() > k) frecuentes.resize(k);
+        return frecuentes;
+    }
+
+    size_t size() const { return contadores.size(); }
+    size_t getCapacidad() const { return capacidad; }
+    long long getTotal() const { return total; }
+    int getMinimo() const { return (int)minimo(); }
+
+    // Bytes usados; los nodos del unordered_map se estiman (clave, valor, hash y puntero)
+    size_t getSize() const {
+        return contadores.capacity() * sizeof(Contador)
+             + cubetas.capacity() * sizeof(Cubeta)
+             + cubetasLibres.capacity() * sizeof(int)
+             + indice.bucket_count() * sizeof(void*)
+             + indice.size() * (sizeof(std::pair<const uint64_t, int>) + 2 * sizeof(void*));
+    }
+};
+
+#endif // SPACE_SAVING_H
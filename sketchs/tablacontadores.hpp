@@ -0,0 +1,154 @@
+#ifndef TABLA_CONTADORES_H
+#define TABLA_CONTADORES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <sys/mman.h>
+
+/**
+ * Matriz de contadores filas x columnas en un único buffer contiguo y alineado a 64 bytes
+ * Cada fila ocupa un múltiplo de 64 bytes (paso >= columnas), de modo que todas empiezan
+ * en una línea de caché propia y no hay un puntero extra por fila como en vector<vector<T>>.
+ * Opcionalmente el buffer se pide con mmap y páginas grandes (hugetlb si hay páginas
+ * reservadas, si no transparent huge pages) para reducir fallos de TLB en tablas grandes.
+ * T puede ser std::atomic de un entero sin candado (ver CountSketchConcurrente): el buffer se
+ * inicializa y copia byte a byte, lo que es válido para esos atómicos en las ABI soportadas.
+ * También puede ser una vista sobre los contadores de un archivo mapeado (ver archivosketch.hpp),
+ * que se libera junto con la última tabla que use el mapa.
+ */
+template<typename T>
+class TablaContadores
+{
+    static_assert(std::is_trivially_destructible<T>::value && std::is_standard_layout<T>::value,
+                  "Los contadores deben poder inicializarse y copiarse byte a byte");
+
+private:
+    int filas, columnas;
+    size_t paso;            // elementos por fila incluyendo el relleno
+    size_t bytes;           // bytes reservados
+    bool mapeada;           // true si el buffer viene de mmap
+    T *datos;
+    std::shared_ptr<void> archivo;  // dueño del buffer si es una vista sobre un archivo mapeado
+
+    void reservar(bool paginasGrandes) {
+        bytes = filas * paso * sizeof(T);
+        mapeada = false;
+        datos = nullptr;
+
+        if (paginasGrandes && bytes >= PAGINA_GRANDE) {
+            size_t largo = (bytes + PAGINA_GRANDE - 1) / PAGINA_GRANDE * PAGINA_GRANDE;
+            void *p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+            p = mmap(nullptr, largo, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+            if (p == MAP_FAILED) {
+                p = mmap(nullptr, largo, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+                if (p != MAP_FAILED) madvise(p, largo, MADV_HUGEPAGE);
+#endif
+            }
+            if (p != MAP_FAILED) {
+                bytes = largo;
+                mapeada = true;
+                datos = static_cast<T*>(p); // mmap anónimo ya viene en cero
+                return;
+            }
+        }
+
+        datos = static_cast<T*>(std::aligned_alloc(LINEA_CACHE, bytes));
+        if (datos == nullptr) throw std::bad_alloc();
+        std::memset(static_cast<void*>(datos), 0, bytes);
+    }
+
+    void liberar() {
+        if (archivo) {
+            archivo.reset();
+            datos = nullptr;
+            return;
+        }
+        if (datos == nullptr) return;
+        if (mapeada) munmap(datos, bytes);
+        else std::free(datos);
+        datos = nullptr;
+    }
+
+public:
+    static const size_t LINEA_CACHE = 64;
+    static const size_t PAGINA_GRANDE = 2 << 20;
+
+    TablaContadores(int filas, int columnas, bool paginasGrandes = false)
+        : filas(filas), columnas(columnas) {
+        paso = pasoPara(columnas);
+        reservar(paginasGrandes);
+    }
+
+    /**
+     * Vista sobre filas * pasoPara(columnas) contadores que ya están en memoria de otro dueño
+     * @param datos Primer contador, alineado a LINEA_CACHE
+     * @param archivo Dueño del buffer (el mapa de un archivo); se mantiene vivo con la tabla
+     */
+    TablaContadores(int filas, int columnas, T *datos, std::shared_ptr<void> archivo)
+        : filas(filas), columnas(columnas), paso(pasoPara(columnas)),
+          bytes(filas * paso * sizeof(T)), mapeada(false), datos(datos), archivo(std::move(archivo)) {}
+
+    // elementos por fila incluyendo el relleno hasta la siguiente línea de caché
+    static size_t pasoPara(int columnas) {
+        const size_t porLinea = LINEA_CACHE / sizeof(T);
+        return (columnas + porLinea - 1) / porLinea * porLinea;
+    }
+
+    TablaContadores(const TablaContadores &otra)
+        : filas(otra.filas), columnas(otra.columnas), paso(otra.paso) {
+        reservar(otra.mapeada);
+        std::memcpy(static_cast<void*>(datos), static_cast<const void*>(otra.datos), filas * paso * sizeof(T));
+    }
+
+    TablaContadores(TablaContadores &&otra) noexcept
+        : filas(otra.filas), columnas(otra.columnas), paso(otra.paso),
+          bytes(otra.bytes), mapeada(otra.mapeada), datos(otra.datos), archivo(std::move(otra.archivo)) {
+        otra.datos = nullptr;
+    }
+
+    TablaContadores &operator=(TablaContadores otra) noexcept {
+        std::swap(filas, otra.filas);
+        std::swap(columnas, otra.columnas);
+        std::swap(paso, otra.paso);
+        std::swap(bytes, otra.bytes);
+        std::swap(mapeada, otra.mapeada);
+        std::swap(datos, otra.datos);
+        std::swap(archivo, otra.archivo);
+        return *this;
+    }
+
+    ~TablaContadores() {
+        liberar();
+    }
+
+    T *fila(int j) { return datos + j * paso; }
+    const T *fila(int j) const { return datos + j * paso; }
+
+    T &operator()(int j, int i) { return datos[j * paso + i]; }
+    const T &operator()(int j, int i) const { return datos[j * paso + i]; }
+
+    int getFilas() const { return filas; }
+    int getColumnas() const { return columnas; }
+    size_t getPaso() const { return paso; }
+
+    // bytes realmente reservados, incluyendo relleno y redondeo a páginas grandes
+    size_t getBytesReservados() const { return bytes; }
+
+    // true si el buffer quedó respaldado por mmap con páginas grandes
+    bool usaPaginasGrandes() const { return mapeada; }
+
+    // true si los contadores están en un archivo mapeado en vez de memoria propia
+    bool enArchivo() const { return (bool)archivo; }
+};
+
+#endif // TABLA_CONTADORES_H
@@ -2,59 +2,199 @@
 #define TOWER_SKETCH_H
 
 
-#include "murmurhash32.hpp"
+#include "mixhash64.hpp"
+#include "tablacontadores.hpp"
+#include "archivosketch.hpp"
 #include <climits>
+#include <limits>
 
 /**
  * CountMin sketch con conservative update y template para el tamaño de los contadores
  * 
+ * Las claves enteras son k-mers canónicos empaquetados en 2 bits (ver utils/CodificadorKmers.hpp)
  */
 template<typename T>
 class CountMinCU
 {
 private:
     int d,w;
-    std::vector<std::vector<T>> tabla;
-    // retorna el reverso complementario de la cadena de ADN
-std::string revComp(const std::string &s) {
-    std::string rc = s;
-    for (char &c : rc) {
-        switch(c) {
-            case 'A': c = 'T'; break;
-            case 'T': c = 'A'; break;
-            case 'C': c = 'G'; break;
-            case 'G': c = 'C'; break;
+    uint64_t semilla;
+    TablaContadores<T> tabla;
+
+    static int validarFilas(int d, int w) {
+        if (d <= 0 || d > D_MAX || w <= 0) {
+            throw std::invalid_argument("Dimensiones de CountMinCU invalidas");
         }
+        return d;
     }
-    std::reverse(rc.begin(), rc.end());
-    return rc;
-}
-// retorna el k-mer canónico (lexicográficamente mínimo entre la cadena y su reverso complementario)
-std::string canonical(const std::string &s) {
-    std::string rc = revComp(s);
-    return std::min(s, rc); // lexicográficamente mínimo
-}
+
 public:
-    CountMinCU(int d, int w): d(d), w(w), tabla(d, std::vector<T>(w,0)) {};
+    static const int D_MAX = HashFilas::FILAS_MAX;
+    static const int VENTANA_PREFETCH = 8; // k-mers hasheados por adelantado en estimateBatch
+
+    CountMinCU(int d, int w, uint64_t semilla = 0, bool paginasGrandes = false)
+        : d(validarFilas(d, w)), w(w), semilla(semilla), tabla(d, w, paginasGrandes) {}
+
+    // sobre una tabla ya llena (cargada de un archivo)
+    CountMinCU(uint64_t semilla, TablaContadores<T> &&tabla)
+        : d(validarFilas(tabla.getFilas(), tabla.getColumnas())), w(tabla.getColumnas()),
+          semilla(semilla), tabla(std::move(tabla)) {}
+
+    // tipo con que se identifica en los archivos de sketch
+    static TipoSketch tipoArchivo() {
+        static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4, "Contadores de 8, 16 o 32 bits");
+        return sizeof(T) == 1 ? TipoSketch::CountMinCU8
+             : sizeof(T) == 2 ? TipoSketch::CountMinCU16 : TipoSketch::CountMinCU32;
+    }
+
+    // Guarda la tabla en el formato de archivosketch.hpp (ver CountSketch::save)
+    void save(const std::string &ruta, int k = 0) const {
+        EscritorSketch escritor(tipoArchivo(), k);
+        agregarA(escritor);
+        escritor.escribir(ruta);
+    }
+
+    // agrega la tabla a un archivo en construcción (TowerSketch guarda sus tres capas)
+    void agregarA(EscritorSketch &escritor) const {
+        escritor.agregarTabla(tabla, semilla);
+    }
+
+    static CountMinCU load(const LectorSketch &lector) {
+        lector.validar(tipoArchivo(), 1);
+        return desdeArchivo(lector, 0);
+    }
+
+    static CountMinCU load(const std::string &ruta, bool mapear = true) {
+        return load(LectorSketch(ruta, mapear));
+    }
+
+    // la tabla i de un archivo ya validado
+    static CountMinCU desdeArchivo(const LectorSketch &lector, size_t i) {
+        return CountMinCU(lector.getTabla(i).semilla, lector.template tabla<T>(i));
+    }
+
+    uint64_t getSemilla() const { return semilla; }
+
+    // hash de la clave para todas las filas, reutilizable entre estimate e insert
+    HashFilas hashear(uint64_t kmer) const {
+        return HashFilas(kmer, semilla);
+    }
+
+    // calcula las columnas de la clave en todas las filas
+    void columnas(const HashFilas &h, uint32_t *cols) const {
+        for (int j = 0; j < d; j++) {
+            cols[j] = h.columna(j, w);
+        }
+    }
+
+    /**
+     * Conservative update: incrementa solo los contadores que valen el mínimo
+     * @param cols Columnas de la clave en cada fila (ver columnas())
+     * @param estimacion Si no es nulo, recibe la estimación de la clave después de insertarla
+     * @return false sin modificar nada si el mínimo ya está saturado en el máximo de T
+     */
+    bool tryInsert(const uint32_t *cols, T *estimacion = nullptr) {
+        T frec_estimada = std::numeric_limits<T>::max();
+        for (int j = 0; j < d; j++) {
+            frec_estimada = std::min(frec_estimada, tabla(j, cols[j]));
+        }
+        if (frec_estimada == std::numeric_limits<T>::max()) return false;
+
+        for (int j = 0; j < d; j++) {
+            tabla(j, cols[j]) += (tabla(j, cols[j]) == frec_estimada); // sin saltos: evita fallos de predicción
+        }
+        if (estimacion != nullptr) *estimacion = frec_estimada + 1;
+        return true;
+    }
+
+    bool tryInsert(const HashFilas &h) {
+        uint32_t cols[D_MAX];
+        columnas(h, cols);
+        return tryInsert(cols);
+    }
+
+    void insert(const HashFilas &h) {
+        tryInsert(h);
+    }
+
+    // trae a caché los d contadores de la clave; escritura = false si solo se van a leer
+    void prefetch(const uint32_t *cols, bool escritura = true) const {
+        for (int j = 0; j < d; j++) {
+            if (escritura) {
+                __builtin_prefetch(&tabla(j, cols[j]), 1);
+            } else {
+                __builtin_prefetch(&tabla(j, cols[j]), 0);
+            }
+        }
+    }
+
+    void insert(uint64_t kmer) {
+        insert(hashear(kmer));
+    }
 
     void insert(const std::string &kmer) {
-        std::string canon = canonical(kmer);
-        int frec_estimada = estimate(kmer);
+        insert(claveKmer(kmer));
+    }
+
+    // mínimo de los contadores en las columnas dadas (ver columnas())
+    T estimate(const uint32_t *cols) const {
+        T frec_est = std::numeric_limits<T>::max();
         for (int j = 0; j < d; j++) {
-            if(tabla[j][murmurhash(canon, j) % w] == frec_estimada)
-                tabla[j][murmurhash(canon, j) % w]++;
+            frec_est = std::min(frec_est, tabla(j, cols[j]));
         }
+        return frec_est;
     }
 
-    T estimate(const std::string &kmer) {
-        std::string canon = canonical(kmer);
-        T frec_est = INT_MAX;
+    T estimate(const HashFilas &h) const {
+        T frec_est = std::numeric_limits<T>::max();
         for (int j = 0; j < d; j++) {
-            frec_est = std::min(frec_est, tabla[j][murmurhash(canon, j) % w]);
+            frec_est = std::min(frec_est, tabla(j, h.columna(j, w)));
         }
         return frec_est;
     }
 
+    T estimate(uint64_t kmer) const {
+        return estimate(hashear(kmer));
+    }
+
+    T estimate(const std::string &kmer) const {
+        return estimate(claveKmer(kmer));
+    }
+
+    /**
+     * Estima n k-mers, equivalente a estimate() uno por uno, con prefetch de lectura de los
+     * VENTANA_PREFETCH siguientes; solo lee la tabla, así que admite hilos concurrentes
+     */
+    void estimateBatch(const uint64_t *kmers, size_t n, T *estimaciones) const {
+        uint32_t pendientes[VENTANA_PREFETCH][D_MAX];
+        auto preparar = [&](size_t i) {
+            uint32_t *cols = pendientes[i % VENTANA_PREFETCH];
+            columnas(hashear(kmers[i]), cols);
+            prefetch(cols, false);
+        };
+        size_t adelantados = std::min(n, (size_t)VENTANA_PREFETCH);
+        for (size_t i = 0; i < adelantados; i++) preparar(i);
+        for (size_t i = 0; i < n; i++) {
+            estimaciones[i] = estimate(pendientes[i % VENTANA_PREFETCH]);
+            if (i + VENTANA_PREFETCH < n) preparar(i + VENTANA_PREFETCH);
+        }
+    }
+
+    // Suma contador a contador otra tabla con las mismas dimensiones y semilla, saturando en el máximo de T
+    void merge(const CountMinCU &otro) {
+        if (d != otro.d || w != otro.w || semilla != otro.semilla) {
+            throw std::invalid_argument("No se pueden combinar CountMinCU con distintas dimensiones o semilla");
+        }
+        const T maximo = std::numeric_limits<T>::max();
+        for (int j = 0; j < d; j++) {
+            T *fila = tabla.fila(j);
+            const T *filaOtro = otro.tabla.fila(j);
+            for (int i = 0; i < w; i++) {
+                fila[i] = (filaOtro[i] > maximo - fila[i]) ? maximo : fila[i] + filaOtro[i];
+            }
+        }
+    }
+
     size_t getSize() {
         return d * w * sizeof(T);
     }
@@ -71,45 +211,173 @@ private:
     CountMinCU<uint8_t> countMin8;
     CountMinCU<uint16_t> countMin16;
     CountMinCU<uint32_t> countMin32;
+    int replicas = 1;   // sketches sumados con merge, ver completar()
 
-public:
-    TowerSketch(int d8, int w8, int d16, int w16, int d32, int w32):
-      countMin8(CountMinCU<uint8_t>(d8, w8)),
-      countMin16(CountMinCU<uint16_t>(d16, w16)),
-      countMin32(CountMinCU<uint32_t>(d32, w32)) {}
-
-    TowerSketch(int d, int w):
-      countMin8(CountMinCU<uint8_t>(d, w)),
-      countMin16(CountMinCU<uint16_t>(d, w)),
-      countMin32(CountMinCU<uint32_t>(d, w)) {}
+    TowerSketch(CountMinCU<uint8_t> &&countMin8, CountMinCU<uint16_t> &&countMin16, CountMinCU<uint32_t> &&countMin32,
+                int replicas)
+        : countMin8(std::move(countMin8)), countMin16(std::move(countMin16)), countMin32(std::move(countMin32)),
+          replicas(replicas) {}
 
-    void insert(const std::string &kmer) {
-        
-        uint8_t est8 = countMin8.estimate(kmer);
-        if (est8 < UINT8_MAX) {
-            countMin8.insert(kmer);
-            return;
-        }
-        uint16_t est16 = countMin16.estimate(kmer);
-        if (est16 < UINT16_MAX) {
-            countMin16.insert(kmer);
-            return;
+    // hashear8(i) retorna el hash de la capa de 8 bits del i-ésimo k-mer; ver insertBatch(kmers, n, estimaciones)
+    template<typename Hashear>
+    void insertarLote(const uint64_t *kmers, size_t n, Hashear hashear8, int *estimaciones = nullptr) {
+        uint32_t pendientes[VENTANA_PREFETCH][CountMinCU<uint8_t>::D_MAX];
+        auto preparar = [&](size_t i) {
+            uint32_t *cols = pendientes[i % VENTANA_PREFETCH];
+            countMin8.columnas(hashear8(i), cols);
+            countMin8.prefetch(cols);
+        };
+        size_t adelantados = std::min(n, (size_t)VENTANA_PREFETCH);
+        for (size_t i = 0; i < adelantados; i++) preparar(i);
+        for (size_t i = 0; i < n; i++) {
+            uint8_t est8 = UINT8_MAX;
+            if (!countMin8.tryInsert(pendientes[i % VENTANA_PREFETCH], &est8) &&
+                !countMin16.tryInsert(countMin16.hashear(kmers[i]))) {
+                countMin32.insert(kmers[i]);
+            }
+            if (estimaciones != nullptr) estimaciones[i] = completar(est8, kmers[i]);
+            if (i + VENTANA_PREFETCH < n) preparar(i + VENTANA_PREFETCH);
         }
-        countMin32.insert(kmer);
-        return;
     }
 
-    int estimate(const std::string &kmer) {
-        uint8_t est8 = countMin8.estimate(kmer);
+    /**
+     * Estimación a partir de la de la capa de 8 bits; sube de capa solo si está saturada
+     * En un sketch combinado de varias réplicas cada una pudo absorber hasta UINT8_MAX
+     * inserciones en su capa de 8 bits (y UINT16_MAX en la de 16) antes de subir de capa, así
+     * que una capa saturada cuenta por replicas veces su máximo; con una sola réplica es la
+     * estimación de siempre.
+     */
+    int completar(uint8_t est8, uint64_t kmer) const {
         if (est8 < UINT8_MAX) return est8;
 
         uint16_t est16 = countMin16.estimate(kmer);
-        if (est16 < UINT16_MAX) return UINT8_MAX + est16;
+        if (est16 < UINT16_MAX) return replicas * UINT8_MAX + est16;
 
         uint32_t est32 = countMin32.estimate(kmer);
-        return UINT8_MAX + UINT16_MAX + est32;
+        return replicas * (UINT8_MAX + UINT16_MAX) + est32;
+    }
+
+public:
+    static const int VENTANA_PREFETCH = 8; // k-mers hasheados por adelantado en insertBatch y estimateBatch
+
+    // cada capa usa su propia semilla para que sus colisiones no se repitan entre capas
+    TowerSketch(int d8, int w8, int d16, int w16, int d32, int w32,
+                uint64_t semilla = 0, bool paginasGrandes = false):
+      countMin8(CountMinCU<uint8_t>(d8, w8, semilla, paginasGrandes)),
+      countMin16(CountMinCU<uint16_t>(d16, w16, semilla + 1, paginasGrandes)),
+      countMin32(CountMinCU<uint32_t>(d32, w32, semilla + 2, paginasGrandes)) {}
+
+    TowerSketch(int d, int w, uint64_t semilla = 0, bool paginasGrandes = false):
+      TowerSketch(d, w, d, w, d, w, semilla, paginasGrandes) {}
+
+    // las capas superiores solo se hashean si la inferior está saturada
+    void insert(uint64_t kmer) {
+        if (countMin8.tryInsert(countMin8.hashear(kmer))) return;
+        if (countMin16.tryInsert(countMin16.hashear(kmer))) return;
+        countMin32.insert(kmer);
+    }
+
+    void insert(const std::string &kmer) {
+        insert(claveKmer(kmer));
     }
 
+    /**
+     * Inserta n k-mers, equivalente a insert() uno por uno
+     * Solo se adelanta la capa de 8 bits, que es donde termina casi toda inserción;
+     * las capas superiores se hashean al momento si la inferior está saturada.
+     */
+    void insertBatch(const uint64_t *kmers, size_t n) {
+        insertarLote(kmers, n, [&](size_t i) { return countMin8.hashear(kmers[i]); });
+    }
+
+    /**
+     * Como insertBatch(kmers, n), y deja en estimaciones[i] la estimación del i-ésimo k-mer
+     * justo después de insertarlo. La de la capa de 8 bits sale del conservative update sin
+     * volver a leer la tabla; las capas superiores solo se consultan si esa capa se saturó.
+     */
+    void insertBatch(const uint64_t *kmers, size_t n, int *estimaciones) {
+        insertarLote(kmers, n, [&](size_t i) { return countMin8.hashear(kmers[i]); }, estimaciones);
+    }
+
+    /**
+     * Igual que insertBatch(kmers, n), con el hash de la capa de 8 bits ya calculado como
+     * HashFilas(kmer, getSemilla()), para reutilizarlo entre varios sketches
+     */
+    void insertBatch(const uint64_t *kmers, const HashFilas *hashes, size_t n) {
+        insertarLote(kmers, n, [&](size_t i) { return hashes[i]; });
+    }
+
+    int estimate(uint64_t kmer) const {
+        return completar(countMin8.estimate(kmer), kmer);
+    }
+
+    int estimate(const std::string &kmer) const {
+        return estimate(claveKmer(kmer));
+    }
+
+    /**
+     * Estima n k-mers, equivalente a estimate() uno por uno
+     * Como en insertBatch solo se adelanta la capa de 8 bits; las superiores se consultan
+     * al momento para los pocos k-mers que la saturan. Admite hilos concurrentes.
+     */
+    void estimateBatch(const uint64_t *kmers, size_t n, int *estimaciones) const {
+        uint32_t pendientes[VENTANA_PREFETCH][CountMinCU<uint8_t>::D_MAX];
+        auto preparar = [&](size_t i) {
+            uint32_t *cols = pendientes[i % VENTANA_PREFETCH];
+            countMin8.columnas(countMin8.hashear(kmers[i]), cols);
+            countMin8.prefetch(cols, false);
+        };
+        size_t adelantados = std::min(n, (size_t)VENTANA_PREFETCH);
+        for (size_t i = 0; i < adelantados; i++) preparar(i);
+        for (size_t i = 0; i < n; i++) {
+            estimaciones[i] = completar(countMin8.estimate(pendientes[i % VENTANA_PREFETCH]), kmers[i]);
+            if (i + VENTANA_PREFETCH < n) preparar(i + VENTANA_PREFETCH);
+        }
+    }
+
+    /**
+     * Combina otro TowerSketch con las mismas dimensiones y semilla, capa por capa con suma saturada
+     * En cada réplica un k-mer sube de capa cuando su mínimo en la capa inferior se satura, y lo
+     * que esa capa absorbió no pasa a la siguiente al sumar. Por eso el sketch lleva cuántas
+     * réplicas suma (también en el archivo, ver save) y completar() cuenta cada capa saturada
+     * como replicas veces su máximo: la estimación sigue siendo una cota superior, como en el
+     * Count-Min con conservative update, aunque para los k-mers que desbordan la capa de 8 bits
+     * puede sobrestimar hasta en (replicas - 1) * (UINT8_MAX + UINT16_MAX) más que una sola
+     * ingesta.
+     */
+    void merge(const TowerSketch &otro) {
+        countMin8.merge(otro.countMin8);
+        countMin16.merge(otro.countMin16);
+        countMin32.merge(otro.countMin32);
+        replicas += otro.replicas;
+    }
+
+    int getReplicas() const { return replicas; }
+
+    // Guarda las tres capas en un archivo de sketch (ver CountSketch::save)
+    void save(const std::string &ruta, int k = 0) const {
+        EscritorSketch escritor(TipoSketch::TowerSketch, k);
+        escritor.setReplicas(replicas);
+        countMin8.agregarA(escritor);
+        countMin16.agregarA(escritor);
+        countMin32.agregarA(escritor);
+        escritor.escribir(ruta);
+    }
+
+    static TowerSketch load(const LectorSketch &lector) {
+        lector.validar(TipoSketch::TowerSketch, 3);
+        return TowerSketch(CountMinCU<uint8_t>::desdeArchivo(lector, 0),
+                           CountMinCU<uint16_t>::desdeArchivo(lector, 1),
+                           CountMinCU<uint32_t>::desdeArchivo(lector, 2), lector.getReplicas());
+    }
+
+    static TowerSketch load(const std::string &ruta, bool mapear = true) {
+        return load(LectorSketch(ruta, mapear));
+    }
+
+    // semilla de la capa de 8 bits; las de 16 y 32 usan semilla + 1 y semilla + 2
+    uint64_t getSemilla() const { return countMin8.getSemilla(); }
+
     size_t getSize() {
         return countMin8.getSize() + countMin16.getSize() + countMin32.getSize();
     }
@@ -0,0 +1,58 @@
+#ifndef ARCHIVOMAPEADO_H
+#define ARCHIVOMAPEADO_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Archivo completo mapeado en memoria de solo lectura
+ * Las páginas se cargan bajo demanda desde la caché del sistema, sin copiarlas a un buffer
+ * propio, y se pide lectura secuencial (MADV_SEQUENTIAL) para que el kernel adelante
+ * lecturas y libere las páginas ya recorridas. Un archivo vacío queda con largo 0 y sin mapa.
+ */
+class ArchivoMapeado {
+private:
+    const char* datos;
+    size_t largo;
+
+public:
+    explicit ArchivoMapeado(const std::string& filename) : datos(nullptr), largo(0) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("No se pudo abrir el archivo: " + filename);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+            close(fd);
+            throw std::runtime_error("No se puede mapear el archivo: " + filename);
+        }
+        largo = (size_t)info.st_size;
+        if (largo > 0) {
+            void* p = mmap(nullptr, largo, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Falló mmap del archivo: " + filename);
+            }
+            madvise(p, largo, MADV_SEQUENTIAL);
+            datos = static_cast<const char*>(p);
+        }
+        close(fd); // el mapa sigue siendo válido sin el descriptor
+    }
+
+    ArchivoMapeado(const ArchivoMapeado&) = delete;
+    ArchivoMapeado& operator=(const ArchivoMapeado&) = delete;
+
+    ~ArchivoMapeado() {
+        if (datos != nullptr) munmap(const_cast<char*>(datos), largo);
+    }
+
+    const char* data() const { return datos; }
+    size_t size() const { return largo; }
+};
+
+#endif // ARCHIVOMAPEADO_H
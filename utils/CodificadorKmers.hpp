@@ -0,0 +1,153 @@
+#ifndef CODIFICADORKMERS_H
+#define CODIFICADORKMERS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/**
+ * Codificación de k-mers en 2 bits por base (A=00, C=01, G=10, T=11) dentro de un uint64_t,
+ * con la primera base en los bits más significativos. Con este orden, comparar dos k-mers
+ * empaquetados del mismo largo equivale a compararlos lexicográficamente, así que el k-mer
+ * canónico es min(directo, reverso complementario). Soporta k <= 32.
+ */
+
+// Valor que devuelve codificarBase para cualquier carácter distinto de A, C, G, T
+static const uint8_t BASE_INVALIDA = 4;
+
+struct TablaBases {
+    uint8_t codigo[256];
+
+    constexpr TablaBases() : codigo() {
+        for (int i = 0; i < 256; i++) codigo[i] = BASE_INVALIDA;
+        codigo[(unsigned char)'A'] = 0;
+        codigo[(unsigned char)'C'] = 1;
+        codigo[(unsigned char)'G'] = 2;
+        codigo[(unsigned char)'T'] = 3;
+    }
+};
+
+inline constexpr TablaBases TABLA_BASES{};
+
+// retorna el código de 2 bits de la base, o BASE_INVALIDA si no es A, C, G o T
+inline uint8_t codificarBase(char base) {
+    return TABLA_BASES.codigo[(unsigned char)base];
+}
+
+// retorna la máscara con los 2k bits bajos encendidos
+inline uint64_t mascaraKmer(int k) {
+    return (k >= 32) ? ~0ULL : ((1ULL << (2 * k)) - 1);
+}
+
+// retorna el reverso complementario de un k-mer empaquetado
+inline uint64_t reversoComplementario(uint64_t kmer, int k) {
+    uint64_t x = ~kmer; // complemento: A<->T, C<->G
+    // invertir el orden de los pares de bits
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    x = ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);
+    x = ((x >> 16) & 0x0000FFFF0000FFFFULL) | ((x & 0x0000FFFF0000FFFFULL) << 16);
+    x = (x >> 32) | (x << 32);
+    return x >> (64 - 2 * k);
+}
+
+// retorna el k-mer canónico de un k-mer empaquetado
+inline uint64_t canonicoKmer(uint64_t kmer, int k) {
+    return std::min(kmer, reversoComplementario(kmer, k));
+}
+
+/**
+ * Empaqueta un k-mer de texto
+ * @param kmer Cadena de largo <= 32
+ * @param codigo Resultado empaquetado
+ * @return false si la cadena es muy larga o contiene bases distintas de ACGT
+ */
+inline bool codificarKmer(const std::string& kmer, uint64_t& codigo) {
+    if (kmer.empty() || kmer.size() > 32) return false;
+    codigo = 0;
+    for (char c : kmer) {
+        uint8_t b = codificarBase(c);
+        if (b == BASE_INVALIDA) return false;
+        codigo = (codigo << 2) | b;
+    }
+    return true;
+}
+
+// escribe en salida el texto de un k-mer empaquetado, reutilizando su memoria
+inline void decodificarKmer(uint64_t kmer, int k, std::string& salida) {
+    static const char BASES[4] = {'A', 'C', 'G', 'T'};
+    salida.resize(k);
+    for (int i = k - 1; i >= 0; i--) {
+        salida[i] = BASES[kmer & 3];
+        kmer >>= 2;
+    }
+}
+
+inline std::string decodificarKmer(uint64_t kmer, int k) {
+    std::string salida;
+    decodificarKmer(kmer, k, salida);
+    return salida;
+}
+
+/**
+ * Ventana deslizante de k bases que mantiene el k-mer directo y su reverso complementario
+ * empaquetados. Cada base se agrega en O(1); una base inválida (N, minúscula, separador)
+ * reinicia la ventana, por lo que nunca se emiten k-mers que la contengan.
+ */
+class KmerRodante {
+private:
+    int k;
+    uint64_t mascara;
+    int desplazamientoRC;  // posición de la base más reciente en el reverso complementario
+    uint64_t directo;
+    uint64_t reverso;
+    int validas;           // bases válidas consecutivas, saturado en k
+
+public:
+    static const int K_MAX = 32;
+
+    explicit KmerRodante(int k = 1)
+        : k(k), mascara(mascaraKmer(k)), desplazamientoRC(2 * (k - 1)),
+          directo(0), reverso(0), validas(0) {
+        if (k <= 0 || k > K_MAX) {
+            throw std::invalid_argument("El valor de k debe estar entre 1 y 32");
+        }
+    }
+
+    // descarta las bases acumuladas
+    void reset() {
+        directo = 0;
+        reverso = 0;
+        validas = 0;
+    }
+
+    /**
+     * Agrega una base al final de la ventana
+     * @return true si las últimas k bases forman un k-mer válido
+     */
+    bool push(char base) {
+        uint8_t b = codificarBase(base);
+        if (b == BASE_INVALIDA) {
+            validas = 0;
+            return false;
+        }
+        return pushCodigo(b);
+    }
+
+    // Igual que push, para una base ya codificada (0 a 3)
+    bool pushCodigo(uint8_t b) {
+        directo = ((directo << 2) | b) & mascara;
+        reverso = (reverso >> 2) | (uint64_t(3 - b) << desplazamientoRC);
+        validas += (validas < k);
+        return validas == k;
+    }
+
+    uint64_t getDirecto() const { return directo; }
+    uint64_t getReverso() const { return reverso; }
+    uint64_t getCanonico() const { return std::min(directo, reverso); }
+    int getK() const { return k; }
+    int getValidas() const { return validas; }
+};
+
+#endif // CODIFICADORKMERS_H
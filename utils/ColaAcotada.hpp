@@ -0,0 +1,62 @@
+#ifndef COLAACOTADA_H
+#define COLAACOTADA_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/**
+ * Cola productor/consumidor con capacidad máxima, segura entre hilos
+ * push bloquea mientras la cola está llena; pop bloquea mientras está vacía y
+ * retorna false cuando la cola fue cerrada y ya no quedan elementos.
+ */
+template<typename T>
+class ColaAcotada {
+private:
+    std::deque<T> elementos;
+    size_t capacidad;
+    bool cerrada;
+    std::mutex mutex;
+    std::condition_variable hayEspacio;
+    std::condition_variable hayElementos;
+
+public:
+    explicit ColaAcotada(size_t capacidad) : capacidad(capacidad), cerrada(false) {}
+
+    /**
+     * Agrega un elemento, esperando si la cola está llena
+     * @return false si la cola fue cerrada y el elemento se descartó
+     */
+    bool push(T elemento) {
+        std::unique_lock<std::mutex> lock(mutex);
+        hayEspacio.wait(lock, [this] { return cerrada || elementos.size() < capacidad; });
+        if (cerrada) return false;
+        elementos.push_back(std::move(elemento));
+        hayElementos.notify_one();
+        return true;
+    }
+
+    /**
+     * Saca el elemento más antiguo, esperando si la cola está vacía
+     * @return false si la cola está cerrada y vacía
+     */
+    bool pop(T& elemento) {
+        std::unique_lock<std::mutex> lock(mutex);
+        hayElementos.wait(lock, [this] { return cerrada || !elementos.empty(); });
+        if (elementos.empty()) return false;
+        elemento = std::move(elementos.front());
+        elementos.pop_front();
+        hayEspacio.notify_one();
+        return true;
+    }
+
+    // Indica que no habrá más elementos; despierta a todos los que esperan
+    void cerrar() {
+        std::lock_guard<std::mutex> lock(mutex);
+        cerrada = true;
+        hayEspacio.notify_all();
+        hayElementos.notify_all();
+    }
+};
+
+#endif // COLAACOTADA_H
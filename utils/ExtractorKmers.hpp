@@ -0,0 +1,271 @@
+#ifndef EXTRACTORKMERS_H
+#define EXTRACTORKMERS_H
+
+#include "CodificadorKmers.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Extracción de k-mers canónicos directamente sobre los bytes de un FASTA
+ *
+ * Recorre el texto en su lugar, sin copiarlo: salta las líneas de cabecera (desde '>'
+ * hasta el fin de línea) y los saltos de línea ('\n', '\r'), y pasa el resto de los
+ * caracteres a un KmerRodante. Cada cabecera reinicia la ventana, así que ningún k-mer
+ * cruza de un registro al siguiente. Sobre una secuencia ya limpia (sin cabeceras ni
+ * saltos) da exactamente los mismos k-mers. El estado (ventana y si se está dentro de una
+ * cabecera) se conserva entre llamadas, así que un texto puede entregarse por partes.
+ */
+class ExtractorKmers {
+private:
+    KmerRodante rodante;
+    bool enCabecera;
+
+public:
+    explicit ExtractorKmers(int k = 1) : rodante(k), enCabecera(false) {}
+
+    // descarta la ventana y el estado de cabecera
+    void reset() {
+        rodante.reset();
+        enCabecera = false;
+    }
+
+    int getK() const { return rodante.getK(); }
+
+    /**
+     * Extrae hasta max k-mers canónicos desde datos[pos], avanzando pos
+     * @param datos Texto FASTA (o secuencia limpia)
+     * @param largo Largo del texto
+     * @param pos Posición actual; al retornar apunta al primer byte no consumido
+     * @param kmers Arreglo de salida con espacio para max elementos
+     * @param max Máximo de k-mers a extraer
+     * @return Número de k-mers escritos; menos de max solo si se llegó a largo
+     */
+    size_t extraer(const char* datos, size_t largo, size_t& pos, uint64_t* kmers, size_t max) {
+        size_t n = 0;
+        size_t p = pos;
+        while (p < largo && n < max) {
+            if (enCabecera) {
+                const void* finLinea = std::memchr(datos + p, '\n', largo - p);
+                if (finLinea == nullptr) {
+                    p = largo;
+                    break;
+                }
+                p = static_cast<const char*>(finLinea) - datos + 1;
+                enCabecera = false;
+                continue;
+            }
+            char c = datos[p++];
+            uint8_t b = codificarBase(c);
+            if (b != BASE_INVALIDA) {
+                if (rodante.pushCodigo(b)) kmers[n++] = rodante.getCanonico();
+            } else if (c == '>') {
+                rodante.reset(); // nuevo registro
+                enCabecera = true;
+            } else if (c != '\n' && c != '\r') {
+                rodante.reset(); // N u otra base inválida
+            }
+        }
+        pos = p;
+        return n;
+    }
+};
+
+/**
+ * Extracción de k-mers canónicos para varios k en una sola pasada sobre el texto
+ *
+ * Recorre el FASTA igual que ExtractorKmers, pero con una única ventana del mayor k: el
+ * k-mer directo de un k menor son los 2k bits bajos de esa ventana y su reverso
+ * complementario, los 2k bits altos del reverso. Cada base se decodifica una vez y se
+ * entrega a todos los k, así que leer y recorrer la entrada cuesta lo mismo sin importar
+ * cuántos k se pidan. Los k-mers de ks[i] se escriben en kmers[i].
+ *
+ * acotar() limita qué k-mers se emiten según la posición de su última base, para los
+ * fragmentos solapados de la ingesta paralela (ver IngestaParalela.hpp): con el solape del
+ * mayor k, los k menores repetirían k-mers del fragmento vecino.
+ */
+class ExtractorMultiK {
+private:
+    std::vector<int> ks;
+    KmerRodante rodante;                // ventana del mayor k
+    std::vector<uint64_t> mascaras;
+    std::vector<int> desplazamientos;   // del reverso del mayor k al de cada k
+    size_t desde;
+    std::vector<size_t> hasta;
+    bool enCabecera;
+
+    static int mayorK(const std::vector<int>& ks) {
+        if (ks.empty()) {
+            throw std::invalid_argument("Se necesita al menos un valor de k");
+        }
+        return *std::max_element(ks.begin(), ks.end());
+    }
+
+public:
+    explicit ExtractorMultiK(const std::vector<int>& ks = {1})
+        : ks(ks), rodante(mayorK(ks)), desde(0), hasta(ks.size(), SIZE_MAX), enCabecera(false) {
+        for (int k : ks) {
+            KmerRodante validar(k); // valida cada k
+            mascaras.push_back(mascaraKmer(k));
+            desplazamientos.push_back(2 * (rodante.getK() - k));
+        }
+    }
+
+    // descarta la ventana, el estado de cabecera y los límites de acotar()
+    void reset() {
+        rodante.reset();
+        enCabecera = false;
+        desde = 0;
+        std::fill(hasta.begin(), hasta.end(), SIZE_MAX);
+    }
+
+    /**
+     * Emite solo los k-mers cuya última base está en [desde, hasta[i])
+     * @param hasta Un límite por cada k, o nullptr para no limitar el final
+     */
+    void acotar(size_t desde, const size_t* hasta = nullptr) {
+        this->desde = desde;
+        for (size_t i = 0; i < ks.size(); i++) {
+            this->hasta[i] = (hasta == nullptr) ? SIZE_MAX : hasta[i];
+        }
+    }
+
+    const std::vector<int>& getKs() const { return ks; }
+    int getKMax() const { return rodante.getK(); }
+
+    /**
+     * Extrae los k-mers canónicos de cada k desde datos[pos], avanzando pos
+     * Se detiene al llegar a largo o cuando algún n[i] llega a max.
+     * @param kmers kmers[i] es el arreglo de salida de ks[i], con espacio para max elementos
+     * @param n n[i] es cuántos k-mers hay ya en kmers[i]; se escribe a continuación
+     * @return Número de k-mers escritos en total
+     */
+    size_t extraer(const char* datos, size_t largo, size_t& pos, uint64_t* const* kmers, size_t* n, size_t max) {
+        const size_t m = ks.size();
+        bool lleno = false;
+        for (size_t i = 0; i < m; i++) lleno |= (n[i] >= max);
+
+        size_t escritos = 0;
+        size_t p = pos;
+        while (p < largo && !lleno) {
+            if (enCabecera) {
+                const void* finLinea = std::memchr(datos + p, '\n', largo - p);
+                if (finLinea == nullptr) {
+                    p = largo;
+                    break;
+                }
+                p = static_cast<const char*>(finLinea) - datos + 1;
+                enCabecera = false;
+                continue;
+            }
+            char c = datos[p++];
+            uint8_t b = codificarBase(c);
+            if (b != BASE_INVALIDA) {
+                rodante.pushCodigo(b);
+                if (p <= desde) continue;
+                int validas = rodante.getValidas();
+                uint64_t directo = rodante.getDirecto();
+                uint64_t reverso = rodante.getReverso();
+                for (size_t i = 0; i < m; i++) {
+                    if (validas >= ks[i] && p <= hasta[i]) {
+                        kmers[i][n[i]++] = std::min(directo & mascaras[i], reverso >> desplazamientos[i]);
+                        escritos++;
+                        lleno |= (n[i] == max);
+                    }
+                }
+            } else if (c == '>') {
+                rodante.reset(); // nuevo registro
+                enCabecera = true;
+            } else if (c != '\n' && c != '\r') {
+                rodante.reset(); // N u otra base inválida
+            }
+        }
+        pos = p;
+        return escritos;
+    }
+};
+
+/**
+ * Si pos cae dentro de una línea de cabecera, la mueve al inicio de la línea siguiente
+ * Sirve para cortar un FASTA crudo en fragmentos que un ExtractorKmers nuevo pueda
+ * recorrer desde su inicio. Solo se mira hacia atrás hasta desde, que no debe estar dentro
+ * de una cabecera (el corte anterior): así cortar un archivo cuesta lo mismo que recorrerlo
+ * una vez aunque sus líneas sean muy largas.
+ */
+inline size_t saltarCabecera(const char* datos, size_t largo, size_t desde, size_t pos) {
+    const void* finAnterior = memrchr(datos + desde, '\n', pos - desde);
+    size_t inicioLinea = (finAnterior == nullptr) ? desde : static_cast<const char*>(finAnterior) - datos + 1;
+    if (std::memchr(datos + inicioLinea, '>', pos - inicioLinea) == nullptr) return pos;
+    const void* finLinea = std::memchr(datos + pos, '\n', largo - pos);
+    return finLinea == nullptr ? largo : static_cast<const char*>(finLinea) - datos + 1;
+}
+
+/**
+ * Avanza desde pos (fuera de cabecera) hasta haber pasado n caracteres de secuencia,
+ * sin contar saltos de línea. Se detiene antes de una cabecera, porque ningún k-mer
+ * continúa en el registro siguiente.
+ * @return Posición siguiente al n-ésimo carácter de secuencia, la de la cabecera, o largo
+ */
+inline size_t avanzarBases(const char* datos, size_t largo, size_t pos, size_t n) {
+    while (pos < largo && n > 0) {
+        char c = datos[pos];
+        if (c == '>') break;
+        pos++;
+        if (c != '\n' && c != '\r') n--;
+    }
+    return pos;
+}
+
+/**
+ * Estado de un FASTA crudo al final de un bloque, para que el bloque siguiente pueda
+ * recorrerse por separado (ver LectorGenomas::extraerBloque)
+ */
+struct EstadoBloque {
+    std::string cola;           // últimas bases del registro en curso, a anteponer al bloque siguiente
+    bool enCabecera = false;    // el bloque terminó dentro de una línea de cabecera
+};
+
+/**
+ * Actualiza el estado con un bloque más de texto, mirando solo su final
+ * Recorre hacia atrás las últimas líneas hasta juntar n bases o encontrar una cabecera.
+ * @param n Bases a conservar, normalmente k-1
+ */
+inline void avanzarEstado(EstadoBloque& estado, const char* datos, size_t largo, size_t n) {
+    std::string bases; // en orden inverso
+    size_t fin = largo;
+    bool ultima = true;
+    while (true) {
+        size_t ini = fin;
+        while (ini > 0 && datos[ini - 1] != '\n') ini--;
+        bool continua = (ini == 0); // la línea empezó en el bloque anterior
+        bool cabecera = std::memchr(datos + ini, '>', fin - ini) != nullptr || (continua && estado.enCabecera);
+        if (cabecera) {
+            if (ultima) {
+                estado.enCabecera = true;
+                estado.cola.clear();
+                return;
+            }
+            break;
+        }
+        for (size_t i = fin; i > ini && bases.size() < n; i--) {
+            if (datos[i - 1] != '\r') bases.push_back(datos[i - 1]);
+        }
+        if (bases.size() >= n) break;
+        if (continua) {
+            for (auto it = estado.cola.rbegin(); it != estado.cola.rend() && bases.size() < n; ++it) {
+                bases.push_back(*it);
+            }
+            break;
+        }
+        fin = ini - 1; // salta el '\n'
+        ultima = false;
+    }
+    estado.enCabecera = false;
+    estado.cola.assign(bases.rbegin(), bases.rend());
+}
+
+#endif // EXTRACTORKMERS_H
@@ -0,0 +1,70 @@
+#ifndef FLUJOBLOQUES_H
+#define FLUJOBLOQUES_H
+
+#include <cerrno>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * Lectura secuencial por bloques de un archivo, tubería o de la entrada estándar ("-")
+ * No necesita conocer el tamaño de la entrada ni poder retroceder, así que la memoria
+ * usada depende solo del tamaño de bloque que elija quien lee.
+ * leer() es virtual para que FlujoGzip y FlujoFastq entreguen por la misma interfaz el texto
+ * descomprimido o convertido.
+ */
+class FlujoBloques {
+private:
+    int fd;
+    bool propio;    // false para la entrada estándar, que no se cierra
+    bool agotado;
+
+protected:
+    // para flujos que transforman lo que entrega otro flujo y no abren nada propio
+    FlujoBloques() : fd(-1), propio(false), agotado(true) {}
+
+public:
+    explicit FlujoBloques(const std::string& filename) : fd(0), propio(false), agotado(false) {
+        if (filename != "-") {
+            fd = open(filename.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("No se pudo abrir el archivo: " + filename);
+            }
+            propio = true;
+#ifdef POSIX_FADV_SEQUENTIAL
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        }
+    }
+
+    FlujoBloques(const FlujoBloques&) = delete;
+    FlujoBloques& operator=(const FlujoBloques&) = delete;
+
+    virtual ~FlujoBloques() {
+        if (propio) close(fd);
+    }
+
+    /**
+     * Lee hasta capacidad bytes; solo entrega menos si la entrada se acabó
+     * @return Bytes leídos; 0 cuando ya no quedan
+     */
+    virtual size_t leer(char* destino, size_t capacidad) {
+        size_t total = 0;
+        while (!agotado && total < capacidad) {
+            ssize_t n = read(fd, destino + total, capacidad - total);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("Error leyendo la entrada");
+            }
+            if (n == 0) agotado = true;
+            total += (size_t)n;
+        }
+        return total;
+    }
+
+    bool terminado() const { return agotado; }
+};
+
+#endif // FLUJOBLOQUES_H
@@ -0,0 +1,152 @@
+#ifndef FLUJOFASTQ_H
+#define FLUJOFASTQ_H
+
+#include "FlujoBloques.hpp"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Convierte por bloques un archivo FASTQ en un FASTA mínimo, una lectura por registro
+ *
+ * Cada registro de 4 líneas (@cabecera, secuencia, +, calidades) se entrega como ">\n"
+ * seguido de la secuencia, así que el resto del lector (ExtractorKmers, los cortes de la
+ * ingesta paralela) reinicia la ventana en cada lectura y ningún k-mer cruza de una lectura
+ * a otra. Las bases con calidad Phred (offset 33) menor que calidadMinima se reemplazan
+ * por 'N', de modo que ningún k-mer que las contenga llega al sketch. Los registros se
+ * ubican buscando saltos de línea con memchr sobre bloques de TAMANO_ENTRADA bytes; un
+ * registro que queda cortado al final del bloque se completa con la lectura siguiente.
+ * No admite FASTQ con la secuencia repartida en varias líneas.
+ */
+class FlujoFastq : public FlujoBloques {
+private:
+    static const size_t TAMANO_ENTRADA = 4 << 20;  // bytes del FASTQ por lectura del origen
+
+    std::unique_ptr<FlujoBloques> origen;
+    char umbral;                        // carácter de la menor calidad aceptada
+    bool enmascarar;
+
+    std::vector<char> entrada;          // FASTQ pendiente en [ini, fin)
+    size_t ini, fin;
+    bool origenAgotado;
+
+    std::vector<char> salida;           // FASTA convertido, entregado desde posSalida
+    size_t largoSalida, posSalida;
+    size_t lecturas;                    // registros convertidos, para los mensajes de error
+
+    // compacta la entrada y la completa desde el origen, agrandándola si ya estaba llena
+    void rellenarEntrada() {
+        if (ini > 0) {
+            std::memmove(entrada.data(), entrada.data() + ini, fin - ini);
+            fin -= ini;
+            ini = 0;
+        }
+        if (entrada.size() - fin < TAMANO_ENTRADA / 2) {
+            entrada.resize(std::max(entrada.size() * 2, fin + TAMANO_ENTRADA));
+        }
+        size_t n = origen->leer(entrada.data() + fin, entrada.size() - fin - 1);
+        fin += n;
+        if (n == 0) {
+            origenAgotado = true;
+            if (fin > 0 && entrada[fin - 1] != '\n') entrada[fin++] = '\n'; // última línea sin salto
+        }
+    }
+
+    /**
+     * Convierte todos los registros completos de la entrada
+     * @return false si no había ninguno completo
+     */
+    bool convertirRegistros() {
+        if (salida.size() < fin - ini) salida.resize(fin - ini);
+        char* out = salida.data();
+        const char* datos = entrada.data();
+        size_t p = ini;
+        while (true) {
+            while (p < fin && (datos[p] == '\n' || datos[p] == '\r')) p++; // líneas en blanco
+            ini = p;
+            const char* linea[4];
+            size_t largo[4];
+            bool completo = true;
+            for (int l = 0; l < 4; l++) {
+                const char* finLinea = static_cast<const char*>(std::memchr(datos + p, '\n', fin - p));
+                if (finLinea == nullptr) {
+                    completo = false;
+                    break;
+                }
+                linea[l] = datos + p;
+                largo[l] = finLinea - linea[l];
+                if (largo[l] > 0 && linea[l][largo[l] - 1] == '\r') largo[l]--;
+                p = finLinea + 1 - datos;
+            }
+            if (!completo) break;
+            if (largo[0] == 0 || linea[0][0] != '@' || largo[2] == 0 || linea[2][0] != '+' || largo[1] != largo[3]) {
+                throw std::runtime_error("FASTQ mal formado en la lectura " + std::to_string(lecturas + 1));
+            }
+
+            *out++ = '>';
+            *out++ = '\n';
+            const char* secuencia = linea[1];
+            const char* calidad = linea[3];
+            if (enmascarar) {
+                for (size_t i = 0; i < largo[1]; i++) {
+                    out[i] = (calidad[i] < umbral) ? 'N' : secuencia[i];
+                }
+            } else {
+                std::memcpy(out, secuencia, largo[1]);
+            }
+            out += largo[1];
+            *out++ = '\n';
+            lecturas++;
+        }
+        largoSalida = out - salida.data();
+        posSalida = 0;
+        return largoSalida > 0;
+    }
+
+public:
+    /**
+     * @param origen Flujo del que se lee el FASTQ (archivo, gzip o entrada estándar)
+     * @param calidadMinima Calidad Phred mínima de una base; 0 no enmascara ninguna
+     * @param leido Bytes ya leídos del origen que van antes de lo que quede en él
+     */
+    FlujoFastq(std::unique_ptr<FlujoBloques> origen, int calidadMinima = 0,
+               const char* leido = nullptr, size_t largoLeido = 0)
+        : origen(std::move(origen)), umbral((char)(33 + calidadMinima)), enmascarar(calidadMinima > 0),
+          ini(0), fin(0), origenAgotado(false), largoSalida(0), posSalida(0), lecturas(0) {
+        if (calidadMinima < 0 || calidadMinima > 93) {
+            throw std::invalid_argument("La calidad mínima debe estar entre 0 y 93");
+        }
+        entrada.resize(largoLeido + TAMANO_ENTRADA);
+        if (largoLeido > 0) std::memcpy(entrada.data(), leido, largoLeido);
+        fin = largoLeido;
+    }
+
+    size_t leer(char* destino, size_t capacidad) override {
+        size_t total = 0;
+        while (total < capacidad) {
+            if (posSalida == largoSalida) {
+                while (!convertirRegistros()) {
+                    if (origenAgotado) {
+                        if (ini < fin) {
+                            throw std::runtime_error("Archivo FASTQ truncado tras la lectura " + std::to_string(lecturas));
+                        }
+                        return total;
+                    }
+                    rellenarEntrada();
+                }
+            }
+            size_t n = std::min(capacidad - total, largoSalida - posSalida);
+            std::memcpy(destino + total, salida.data() + posSalida, n);
+            posSalida += n;
+            total += n;
+        }
+        return total;
+    }
+
+    size_t getLecturas() const { return lecturas; }
+};
+
+#endif // FLUJOFASTQ_H
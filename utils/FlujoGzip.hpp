@@ -0,0 +1,237 @@
+#ifndef FLUJOGZIP_H
+#define FLUJOGZIP_H
+
+#include "FlujoBloques.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+/**
+ * Lectura por bloques de un archivo gzip, entregando el texto descomprimido
+ *
+ * Si el primer miembro trae el campo extra "BC" de BGZF (bgzip, samtools), el archivo se
+ * trata como una serie de bloques independientes de hasta 64 KiB: se leen LOTE_BGZF bytes
+ * comprimidos, el tamaño descomprimido de cada bloque se toma de su cola (ISIZE) y los
+ * bloques se descomprimen en paralelo, cada uno en su posición de salida. Cualquier otro
+ * gzip (incluidos varios miembros concatenados) se descomprime en un solo hilo con zlib.
+ * Requiere enlazar con -lz.
+ */
+class FlujoGzip : public FlujoBloques {
+private:
+    static const size_t TAMANO_ENTRADA = 1 << 20;    // bytes comprimidos por lectura en gzip común
+    static const size_t CABECERA_GZIP = 12;          // cabecera fija hasta XLEN incluido
+    static const size_t COLA_GZIP = 8;               // CRC32 e ISIZE
+
+    // Bloque BGZF ya ubicado en la entrada y en la salida
+    struct BloqueBgzf {
+        size_t inicio;          // deflate crudo dentro de entrada
+        size_t largo;
+        size_t salida;          // posición en salida
+        uint32_t isize;
+        uint32_t crc;
+    };
+
+    std::string filename;
+    int hilos;
+    bool bgzf;
+
+    std::vector<unsigned char> entrada;     // bytes comprimidos pendientes en [ini, fin)
+    size_t ini, fin;
+
+    std::vector<char> salida;               // texto del último lote BGZF, entregado desde posSalida
+    size_t posSalida;
+
+    z_stream z;                             // gzip común
+    bool enMiembro;
+
+    static uint32_t leer32(const unsigned char* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    // completa la entrada hasta minimo bytes pendientes (o hasta el fin del archivo)
+    void rellenarEntrada(size_t minimo) {
+        if (fin - ini >= minimo) return;
+        if (ini > 0) {
+            std::memmove(entrada.data(), entrada.data() + ini, fin - ini);
+            fin -= ini;
+            ini = 0;
+        }
+        if (entrada.size() < minimo) entrada.resize(minimo);
+        fin += FlujoBloques::leer(reinterpret_cast<char*>(entrada.data()) + fin, entrada.size() - fin);
+    }
+
+    /**
+     * Tamaño total del bloque BGZF que empieza en p, o 0 si la cabecera no es BGZF
+     * @param disponibles Bytes disponibles desde p (al menos CABECERA_GZIP)
+     */
+    static size_t tamanoBloqueBgzf(const unsigned char* p, size_t disponibles) {
+        if (p[0] != 0x1f || p[1] != 0x8b || p[2] != 8 || !(p[3] & 4)) return 0;
+        size_t xlen = p[10] | (p[11] << 8);
+        if (disponibles < CABECERA_GZIP + xlen) return 0;
+        const unsigned char* extra = p + CABECERA_GZIP;
+        // subcampos: SI1, SI2, SLEN (2 bytes) y SLEN bytes de datos; BGZF guarda BSIZE en "BC"
+        size_t i = 0;
+        while (i + 4 <= xlen) {
+            size_t slen = extra[i + 2] | (extra[i + 3] << 8);
+            if (i + 4 + slen > xlen) return 0; // subcampo truncado o mal formado
+            if (extra[i] == 'B' && extra[i + 1] == 'C' && slen == 2) {
+                return (size_t)(extra[i + 4] | (extra[i + 5] << 8)) + 1;
+            }
+            i += 4 + slen;
+        }
+        return 0;
+    }
+
+    static void descomprimirBloque(const unsigned char* deflate, const BloqueBgzf& b, char* destino) {
+        z_stream zb;
+        std::memset(&zb, 0, sizeof(zb));
+        if (inflateInit2(&zb, -15) != Z_OK) throw std::runtime_error("No se pudo iniciar zlib");
+        zb.next_in = const_cast<unsigned char*>(deflate);
+        zb.avail_in = (uInt)b.largo;
+        zb.next_out = reinterpret_cast<unsigned char*>(destino);
+        zb.avail_out = b.isize;
+        int ret = inflate(&zb, Z_FINISH);
+        inflateEnd(&zb);
+        if (ret != Z_STREAM_END || zb.avail_out != 0 ||
+            crc32(0L, reinterpret_cast<unsigned char*>(destino), b.isize) != b.crc) {
+            throw std::runtime_error("Bloque BGZF corrupto");
+        }
+    }
+
+    /**
+     * Descomprime en paralelo los bloques BGZF completos de los próximos LOTE_BGZF bytes
+     * @return false si ya no quedan bloques
+     */
+    bool siguienteLoteBgzf() {
+        rellenarEntrada(LOTE_BGZF);
+        std::vector<BloqueBgzf> bloques;
+        size_t total = 0;
+        size_t p = ini;
+        while (fin - p >= CABECERA_GZIP) {
+            size_t tamano = tamanoBloqueBgzf(entrada.data() + p, fin - p);
+            if (tamano == 0) {
+                throw std::runtime_error("Bloque sin cabecera BGZF en " + filename);
+            }
+            if (fin - p < tamano) break;
+            size_t xlen = entrada[p + 10] | (entrada[p + 11] << 8);
+            BloqueBgzf b;
+            b.inicio = p + CABECERA_GZIP + xlen;
+            b.largo = tamano - CABECERA_GZIP - xlen - COLA_GZIP;
+            b.crc = leer32(entrada.data() + p + tamano - COLA_GZIP);
+            b.isize = leer32(entrada.data() + p + tamano - 4);
+            b.salida = total;
+            total += b.isize;
+            bloques.push_back(b);
+            p += tamano;
+        }
+        if (bloques.empty()) {
+            if (fin > ini) throw std::runtime_error("Archivo BGZF truncado: " + filename);
+            return false;
+        }
+        ini = p;
+
+        salida.resize(total);
+        posSalida = 0;
+        int usados = std::min<int>(hilos, (int)bloques.size());
+        std::vector<std::thread> trabajadores;
+        std::vector<std::exception_ptr> errores(usados);
+        for (int t = 0; t < usados; t++) {
+            trabajadores.emplace_back([&, t]() {
+                try {
+                    for (size_t i = t; i < bloques.size(); i += usados) {
+                        descomprimirBloque(entrada.data() + bloques[i].inicio, bloques[i], salida.data() + bloques[i].salida);
+                    }
+                } catch (...) {
+                    errores[t] = std::current_exception();
+                }
+            });
+        }
+        for (auto& t : trabajadores) t.join();
+        for (auto& e : errores) {
+            if (e) std::rethrow_exception(e);
+        }
+        return true;
+    }
+
+    // gzip común: descomprime directamente en destino
+    size_t leerGzip(char* destino, size_t capacidad) {
+        z.next_out = reinterpret_cast<unsigned char*>(destino);
+        z.avail_out = (uInt)capacidad;
+        while (z.avail_out > 0) {
+            if (z.avail_in == 0) {
+                ini = fin = 0;
+                rellenarEntrada(TAMANO_ENTRADA);
+                if (fin == 0) {
+                    if (enMiembro) throw std::runtime_error("Archivo gzip truncado: " + filename);
+                    break;
+                }
+                z.next_in = entrada.data();
+                z.avail_in = (uInt)fin;
+            }
+            enMiembro = true;
+            int ret = inflate(&z, Z_NO_FLUSH);
+            if (ret == Z_STREAM_END) {
+                enMiembro = false;
+                inflateReset(&z); // puede seguir otro miembro concatenado
+            } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                throw std::runtime_error("Error descomprimiendo " + filename);
+            }
+        }
+        return capacidad - z.avail_out;
+    }
+
+public:
+    static const size_t LOTE_BGZF = 4 << 20; // bytes comprimidos por lote en paralelo
+
+    /**
+     * @param filename Archivo .gz
+     * @param hilos Hilos para descomprimir bloques BGZF (0 = hardware_concurrency)
+     */
+    FlujoGzip(const std::string& filename, int hilos = 0)
+        : FlujoBloques(filename), filename(filename), hilos(hilos), bgzf(false),
+          ini(0), fin(0), posSalida(0), enMiembro(false) {
+        if (this->hilos <= 0) {
+            unsigned int n = std::thread::hardware_concurrency();
+            this->hilos = (n == 0) ? 1 : (int)n;
+        }
+        std::memset(&z, 0, sizeof(z));
+        rellenarEntrada(TAMANO_ENTRADA);
+        if (fin >= 2 && (entrada[0] != 0x1f || entrada[1] != 0x8b)) {
+            throw std::runtime_error("No es un archivo gzip: " + filename);
+        }
+        bgzf = fin >= CABECERA_GZIP && tamanoBloqueBgzf(entrada.data(), fin) > 0;
+        if (!bgzf) {
+            if (inflateInit2(&z, 15 + 16) != Z_OK) throw std::runtime_error("No se pudo iniciar zlib");
+            z.next_in = entrada.data();
+            z.avail_in = (uInt)fin;
+        }
+    }
+
+    ~FlujoGzip() override {
+        if (!bgzf) inflateEnd(&z);
+    }
+
+    size_t leer(char* destino, size_t capacidad) override {
+        if (!bgzf) return leerGzip(destino, capacidad);
+
+        size_t total = 0;
+        while (total < capacidad) {
+            if (posSalida == salida.size() && !siguienteLoteBgzf()) break;
+            size_t n = std::min(capacidad - total, salida.size() - posSalida);
+            std::memcpy(destino + total, salida.data() + posSalida, n);
+            posSalida += n;
+            total += n;
+        }
+        return total;
+    }
+
+    bool esBgzf() const { return bgzf; }
+};
+
+#endif // FLUJOGZIP_H
@@ -0,0 +1,289 @@
+#ifndef INGESTAPARALELA_H
+#define INGESTAPARALELA_H
+
+#include "LectorGenomas.hpp"
+#include "ColaAcotada.hpp"
+#include "CodificadorKmers.hpp"
+#include "ExtractorKmers.hpp"
+#include "OpcionesEjecucion.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Ingesta paralela de k-mers
+ *
+ * El hilo que llama carga los archivos con LectorGenomas y corta cada secuencia en
+ * fragmentos que se solapan en k-1 bases, de modo que cada k-mer empieza en exactamente
+ * un fragmento. Con ModoLectura::Mapeado los fragmentos apuntan al FASTA mapeado: los
+ * cortes se corren fuera de las cabeceras y el solape se cuenta en bases, sin contar
+ * saltos de línea. Con ModoLectura::Flujo se reparten los bloques que entrega
+ * LectorGenomas::extraerBloque, así que la memoria queda acotada por los bloques en la
+ * cola. Los fragmentos se reparten entre `hilos` trabajadores a través de una
+ * ColaAcotada; los archivos chicos quedan en un solo fragmento y los grandes se parten
+ * en uno por hilo. Cada trabajador extrae los k-mers canónicos de sus fragmentos y los
+ * entrega por lotes a procesar(hilo, kmers, n), normalmente para insertarlos en una
+ * réplica privada del sketch que después se combina con merge().
+ * La versión para varios k corta con el solape del mayor k y recorre cada fragmento una
+ * sola vez con ExtractorMultiK, acotando los k menores para que no repitan k-mers.
+ */
+
+// Parte de un archivo ya cargado o mapeado en memoria, compartido entre sus fragmentos
+struct FragmentoSecuencia {
+    DatosArchivo archivo;
+    size_t inicio;
+    size_t corte;   // inicio del fragmento siguiente
+    size_t fin;     // excluyente, incluye las k-1 bases de solape después de corte
+};
+
+// Tamaño mínimo de un fragmento; por debajo no conviene partir un archivo
+static const size_t FRAGMENTO_MINIMO = 1 << 20;
+
+// retorna el número de hilos a usar cuando se pide 0 (automático)
+inline int hilosDisponibles() {
+    unsigned int n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : (int)n;
+}
+
+/**
+ * Corta la entrada del lector en fragmentos solapados en k-1 bases y llama a
+ * trabajar(hilo, fragmento) desde `hilos` trabajadores (ver ingestarEnParalelo)
+ */
+template<typename Trabajar>
+void repartirFragmentos(LectorGenomas& lector, int k, int hilos, Trabajar trabajar) {
+    ColaAcotada<FragmentoSecuencia> cola(4 * hilos);
+    std::exception_ptr error;
+    std::mutex mutexError;
+
+    std::vector<std::thread> trabajadores;
+    for (int h = 0; h < hilos; h++) {
+        trabajadores.emplace_back([&, h]() {
+            try {
+                FragmentoSecuencia fragmento;
+                while (cola.pop(fragmento)) {
+                    trabajar(h, fragmento);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutexError);
+                if (!error) error = std::current_exception();
+                cola.cerrar();
+            }
+        });
+    }
+
+    try {
+        bool abierta = true; // false si un trabajador falló y cerró la cola
+        lector.reset();
+        DatosArchivo archivo;
+        while (abierta && lector.extraerBloque(k, archivo)) {
+            const char* datos = archivo.datos;
+            const size_t largo = archivo.largo;
+            const size_t paso = std::max(FRAGMENTO_MINIMO, (largo + hilos - 1) / hilos);
+            size_t inicio = 0;
+            while (inicio < largo && abierta) {
+                // la secuencia limpia no tiene cabeceras: se corta en cualquier parte
+                size_t corte = (largo - inicio <= paso) ? largo
+                             : archivo.limpia ? inicio + paso
+                             : saltarCabecera(datos, largo, inicio, inicio + paso);
+                size_t fin = avanzarBases(datos, largo, corte, k - 1);
+                abierta = cola.push(FragmentoSecuencia{archivo, inicio, corte, fin});
+                inicio = corte;
+            }
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutexError);
+        if (!error) error = std::current_exception();
+    }
+    cola.cerrar();
+
+    for (auto& t : trabajadores) t.join();
+    if (error) std::rethrow_exception(error);
+}
+
+/**
+ * Recorre todos los archivos del lector en paralelo
+ * @param lector Lector de genomas; se reinicia al primer archivo y termina en el último
+ * @param k Longitud del k-mer (1 a 32)
+ * @param hilos Número de hilos trabajadores (0 = hardware_concurrency)
+ * @param procesar Función procesar(int hilo, const uint64_t* kmers, size_t n), llamada
+ *                 siempre desde el mismo hilo para un índice dado
+ */
+template<typename Procesar>
+void ingestarEnParalelo(LectorGenomas& lector, int k, int hilos, Procesar procesar) {
+    if (hilos <= 0) hilos = hilosDisponibles();
+    KmerRodante validar(k); // valida k antes de lanzar hilos
+
+    std::vector<std::vector<uint64_t>> lotes(hilos, std::vector<uint64_t>(LectorGenomas::TAMANO_LOTE));
+    repartirFragmentos(lector, k, hilos, [&](int h, const FragmentoSecuencia& fragmento) {
+        std::vector<uint64_t>& lote = lotes[h];
+        ExtractorKmers extractor(k);
+        size_t pos = fragmento.inicio;
+        size_t n;
+        while ((n = extractor.extraer(fragmento.archivo.datos, fragmento.fin, pos,
+                                      lote.data(), lote.size())) > 0) {
+            procesar(h, lote.data(), n);
+        }
+    });
+}
+
+/**
+ * Recorre todos los archivos del lector en paralelo extrayendo varios k en la misma pasada
+ * @param ks Longitudes de k-mer (1 a 32)
+ * @param procesar Función procesar(int hilo, size_t indiceK, const uint64_t* kmers, size_t n),
+ *                 con los k-mers de ks[indiceK]
+ */
+template<typename Procesar>
+void ingestarEnParalelo(LectorGenomas& lector, const std::vector<int>& ks, int hilos, Procesar procesar) {
+    if (hilos <= 0) hilos = hilosDisponibles();
+    const ExtractorMultiK validar(ks); // valida los k antes de lanzar hilos
+    const int kMax = validar.getKMax();
+    const size_t m = ks.size();
+
+    // por hilo, un lote de TAMANO_LOTE k-mers para cada k
+    std::vector<std::vector<uint64_t>> lotes(hilos, std::vector<uint64_t>(m * LectorGenomas::TAMANO_LOTE));
+    repartirFragmentos(lector, kMax, hilos, [&](int h, const FragmentoSecuencia& fragmento) {
+        const char* datos = fragmento.archivo.datos;
+        std::vector<uint64_t*> salida(m);
+        std::vector<size_t> hasta(m), n(m);
+        for (size_t i = 0; i < m; i++) {
+            salida[i] = lotes[h].data() + i * LectorGenomas::TAMANO_LOTE;
+            // un k-mer que empieza en corte o después es del fragmento siguiente
+            hasta[i] = avanzarBases(datos, fragmento.fin, fragmento.corte, ks[i] - 1);
+        }
+        ExtractorMultiK extractor(ks);
+        extractor.acotar(fragmento.archivo.solape, hasta.data());
+        size_t pos = fragmento.inicio;
+        do {
+            std::fill(n.begin(), n.end(), 0);
+            extractor.extraer(datos, fragmento.fin, pos, salida.data(), n.data(), LectorGenomas::TAMANO_LOTE);
+            for (size_t i = 0; i < m; i++) {
+                if (n[i] > 0) procesar(h, i, salida[i], n[i]);
+            }
+        } while (pos < fragmento.fin);
+    });
+}
+
+// Diferencias entre las estimaciones de un sketch construido en paralelo y uno secuencial
+struct DiferenciasEstimacion {
+    size_t comparados = 0;
+    size_t distintos = 0;
+    long long maxDiferencia = 0;
+};
+
+/**
+ * Construye `secuencial` con una sola pasada secuencial del lector y compara sus
+ * estimaciones con las de `paralelo` para cada k-mer de `kmers`
+ */
+template<typename SketchType>
+DiferenciasEstimacion compararConSecuencial(const SketchType& paralelo, SketchType& secuencial,
+                                            LectorGenomas& lector, int k,
+                                            const std::vector<uint64_t>& kmers) {
+    std::vector<uint64_t> lote(LectorGenomas::TAMANO_LOTE);
+    size_t n;
+    lector.reset();
+    while ((n = lector.getNextCanonicalKmers(k, lote.data(), lote.size())) > 0) {
+        secuencial.insertBatch(lote.data(), n);
+    }
+
+    DiferenciasEstimacion diferencias;
+    for (uint64_t kmer : kmers) {
+        long long diferencia = std::llabs((long long)paralelo.estimate(kmer) - secuencial.estimate(kmer));
+        diferencias.comparados++;
+        if (diferencia != 0) diferencias.distintos++;
+        diferencias.maxDiferencia = std::max(diferencias.maxDiferencia, diferencia);
+    }
+    return diferencias;
+}
+
+/**
+ * Llena el estado de varios k en una sola pasada por los genomas (calcular_cs, calcular_ts
+ * y calcular_ss)
+ *
+ * Con más de un hilo cada hilo llena su propia réplica de cada proceso, que al final se
+ * combinan; con uno se recorre el lector en secuencia mostrando el avance. Con
+ * opciones.verificar el resultado paralelo se compara contra una pasada secuencial.
+ * Proceso es el estado de un k y debe tener los campos k y totalKmers (que lleva esta
+ * función) y los métodos
+ *   merge(const Proceso& replica)               combina la réplica de un hilo
+ *   verificar(Proceso& vacio, LectorGenomas&)   retorna las DiferenciasEstimacion contra
+ *                                               una pasada secuencial sobre vacio
+ *   progreso()                                  texto que acompaña el avance secuencial
+ * @param insertar Función insertar(Proceso&, kmers, n) con cada lote de k-mers del k del
+ *                 proceso; una réplica se actualiza siempre desde el mismo hilo
+ */
+template<typename Proceso, typename Insertar>
+void ingestarProcesos(std::vector<Proceso>& procesos, const OpcionesEjecucion& opciones, Insertar insertar) {
+    LectorGenomas reader(opciones.entrada, opciones.modoLectura, opciones.lecturaAnticipada,
+                         opciones.calidadMinima);
+
+    std::vector<int> ks;
+    for (const Proceso& p : procesos) ks.push_back(p.k);
+    const size_t m = ks.size();
+
+    int hilos = (opciones.hilos == 0) ? hilosDisponibles() : opciones.hilos;
+    std::cout << "Procesando k-mers de longitud";
+    for (int k : ks) std::cout << " " << k;
+    std::cout << " en una sola pasada" << std::endl;
+
+    if (hilos > 1) {
+        std::cout << "Ingesta paralela con " << hilos << " hilos" << std::endl;
+        std::vector<Proceso> vacios; // para la verificación secuencial
+        if (opciones.verificar) vacios = procesos;
+        std::vector<std::vector<Proceso>> replicas;
+        for (const Proceso& p : procesos) replicas.emplace_back(hilos, p);
+
+        ingestarEnParalelo(reader, ks, hilos, [&](int h, size_t i, const uint64_t* kmers, size_t n) {
+            insertar(replicas[i][h], kmers, n);
+            replicas[i][h].totalKmers += n;
+        });
+
+        // se parte de la primera réplica y no del proceso vacío, que contaría como una réplica
+        // más al combinar (ver TowerSketch::merge)
+        for (size_t i = 0; i < m; i++) {
+            procesos[i] = std::move(replicas[i][0]);
+            for (int h = 1; h < hilos; h++) {
+                procesos[i].merge(replicas[i][h]);
+                procesos[i].totalKmers += replicas[i][h].totalKmers;
+            }
+        }
+
+        if (opciones.verificar) {
+            for (size_t i = 0; i < m; i++) {
+                DiferenciasEstimacion dif = procesos[i].verificar(vacios[i], reader);
+                std::cout << "Verificación " << ks[i] << "-mers contra ingesta secuencial: " << dif.distintos << " de "
+                          << dif.comparados << " estimaciones distintas, diferencia máxima " << dif.maxDiferencia << std::endl;
+            }
+        }
+    } else {
+        std::vector<std::vector<uint64_t>> lotes(m, std::vector<uint64_t>(LectorGenomas::TAMANO_LOTE));
+        std::vector<uint64_t*> salida;
+        for (auto& lote : lotes) salida.push_back(lote.data());
+        std::vector<size_t> n(m);
+        long long siguienteReporte = 1000000;
+
+        reader.reset();
+        while (reader.getNextCanonicalKmers(ks, salida.data(), n.data(), LectorGenomas::TAMANO_LOTE) > 0) {
+            for (size_t i = 0; i < m; i++) {
+                insertar(procesos[i], lotes[i].data(), n[i]);
+                procesos[i].totalKmers += n[i];
+            }
+
+            // Progreso cada 1M k-mers
+            if (procesos[0].totalKmers >= siguienteReporte) {
+                std::cout << "\rProcesados: " << procesos[0].totalKmers << " " << ks[0] << "-mers, "
+                          << procesos[0].progreso() << std::flush;
+                siguienteReporte += 1000000;
+            }
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "Archivos procesados: " << reader.getTotalFiles() << std::endl;
+}
+
+#endif // INGESTAPARALELA_H
@@ -7,12 +7,60 @@
 #include <stdexcept>
 #include <filesystem>
 #include <vector>
+#include <memory>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include "CodificadorKmers.hpp"
+#include "ColaAcotada.hpp"
+#include "ExtractorKmers.hpp"
+#include "ArchivoMapeado.hpp"
+#include "FlujoBloques.hpp"
+#include "FlujoGzip.hpp"
+#include "FlujoFastq.hpp"
 
 /**
- * Clase para leer archivos genómicos en formato FASTA
+ * Forma en que LectorGenomas carga cada archivo
+ *   Completo: lee el archivo línea por línea y guarda la secuencia sin cabeceras en un string
+ *   Mapeado:  mapea el archivo con mmap y extrae los k-mers directamente de sus bytes, sin
+ *             copiar la secuencia; la memoria no depende del tamaño del genoma. Las entradas
+ *             que no se pueden mapear (tuberías, "-") se leen como en Flujo
+ *   Flujo:    lee bloques de TAMANO_BLOQUE bytes y extrae los k-mers de cada uno; la ventana
+ *             continúa de un bloque al siguiente, así que la memoria es constante y la
+ *             entrada puede ser una tubería o la entrada estándar
+ * En todos los modos las cabeceras '>' separan registros: ningún k-mer cruza de un
+ * registro al siguiente. Los archivos .gz se leen siempre por bloques a través de FlujoGzip.
+ * Los FASTQ (por extensión .fq/.fastq, o porque su primer carácter es '@') también se leen
+ * siempre por bloques, convertidos por FlujoFastq: cada lectura es un registro aparte.
+ */
+enum class ModoLectura { Completo, Mapeado, Flujo };
+
+// Bytes del archivo actual entregados por LectorGenomas::extraerDatos, junto con su dueño
+struct DatosArchivo {
+    std::shared_ptr<const void> dueno;  // mantiene vivos los datos (string, mapa o bloque)
+    const char* datos;
+    size_t largo;
+    size_t solape = 0;  // bytes iniciales que repiten el final del tramo anterior (ver extraerBloque)
+    bool limpia = false;    // secuencia de ModoLectura::Completo, sin cabeceras ni saltos de línea
+};
+
+// Tramo preparado por el hilo lector en la lectura anticipada
+struct TramoAnticipado {
+    DatosArchivo datos;
+    size_t indiceArchivo;
+};
+
+/**
+ * Clase para leer archivos genómicos en formato FASTA, o lecturas de secuenciación en FASTQ
  * Permite extraer k-mers de forma secuencial avanzando posición por posición
  */
 class LectorGenomas {
+public:
+    static const size_t TAMANO_LOTE = 4096; // k-mers por lote sugeridos para getNextCanonicalKmers
+    static const size_t TAMANO_BLOQUE = 4 << 20; // bytes por lectura en ModoLectura::Flujo
+    static const char SEPARADOR_REGISTROS = 'N'; // entre registros en la secuencia de ModoLectura::Completo
+    static const size_t TRAMOS_ANTICIPADOS = 2; // tramos preparados de antemano en la lectura anticipada
+
 private:
     std::string genomicData;              
     size_t currentPosition;               
@@ -20,20 +68,224 @@ private:
     size_t currentFileIndex;              
     std::string currentFilename;          
     std::string genomasDirectory;         
+    ModoLectura modo;
+    std::shared_ptr<const ArchivoMapeado> mapa; // archivo actual en ModoLectura::Mapeado
+    std::unique_ptr<FlujoBloques> flujo;  // entrada actual cuando se lee por bloques
+    std::shared_ptr<char[]> bloque;       // bloque actual, precedido por RESERVA_COLA bytes libres
+    size_t largoBloque;
+    size_t bloquesLeidos;                 // del archivo actual
+    EstadoBloque estadoFlujo;             // final del último bloque entregado por extraerBloque
+    bool entradaEstandarLeida;
+    int hilosDescompresion;               // para FlujoGzip; 0 = hardware_concurrency
+    int calidadMinima;                    // para FlujoFastq; 0 = sin enmascarar
+    ExtractorKmers extractor;             // ventana para la extracción de k-mers empaquetados
+    ExtractorMultiK extractorMulti;       // ventana para la extracción de varios k a la vez
+
+    // Lectura anticipada: un hilo lee con `fuente` los tramos siguientes mientras se consume `tramo`
+    bool anticipada;
+    std::unique_ptr<LectorGenomas> fuente;
+    std::unique_ptr<ColaAcotada<TramoAnticipado>> colaTramos;
+    std::thread productor;
+    std::exception_ptr errorProductor;
+    int kTuberia;                         // k con que el hilo corta los tramos
+    DatosArchivo tramo;
+
+    // espacio antes de cada bloque para anteponerle la cola del anterior en extraerBloque
+    static const size_t RESERVA_COLA = KmerRodante::K_MAX;
+
+    // bytes de los que se extraen los k-mers: la secuencia limpia, el FASTA mapeado o el bloque
+    const char* datosActuales() const {
+        if (anticipada) return tramo.datos;
+        if (flujo) return bloque.get() + RESERVA_COLA;
+        return mapa ? mapa->data() : genomicData.data();
+    }
+
+    size_t largoActual() const {
+        if (anticipada) return tramo.largo;
+        if (flujo) return largoBloque;
+        return mapa ? mapa->size() : genomicData.length();
+    }
+
+    // descarta las ventanas de extracción, al cambiar de archivo o de tramo
+    void reiniciarVentanas() {
+        extractor.reset();
+        extractorMulti.reset();
+    }
+
+    // Lector interno del hilo de lectura anticipada, sobre la misma lista de archivos
+    LectorGenomas(const std::vector<std::string>& archivos, const std::string& directory, ModoLectura modo,
+                  int calidadMinima)
+        : currentPosition(0), fastaFiles(archivos), currentFileIndex(0), genomasDirectory(directory), modo(modo),
+          largoBloque(0), bloquesLeidos(0), entradaEstandarLeida(false), hilosDescompresion(0),
+          calidadMinima(calidadMinima), anticipada(false), kTuberia(0) {
+        loadCurrentFile();
+    }
+
+    /**
+     * Lanza el hilo que corta la entrada en tramos para k (ver extraerBloque) y los deja en
+     * una cola de TRAMOS_ANTICIPADOS. Antes de encolar un tramo toca una vez cada página,
+     * para que la lectura desde disco de un archivo mapeado también ocurra en ese hilo.
+     */
+    void iniciarTuberia(int k) {
+        kTuberia = k;
+        errorProductor = nullptr;
+        colaTramos.reset(new ColaAcotada<TramoAnticipado>(TRAMOS_ANTICIPADOS));
+        productor = std::thread([this, k]() {
+            try {
+                DatosArchivo siguiente;
+                while (fuente->extraerBloque(k, siguiente)) {
+                    volatile char sumidero = 0;
+                    for (size_t i = 0; i < siguiente.largo; i += 4096) sumidero ^= siguiente.datos[i];
+                    if (!colaTramos->push(TramoAnticipado{siguiente, fuente->getCurrentFileIndex()})) return;
+                }
+            } catch (...) {
+                errorProductor = std::current_exception();
+            }
+            colaTramos->cerrar();
+        });
+    }
+
+    // Detiene el hilo lector y descarta los tramos pendientes
+    void detenerTuberia() {
+        if (!colaTramos) return;
+        colaTramos->cerrar();
+        productor.join();
+        colaTramos.reset();
+    }
+
+    /**
+     * Pasa al siguiente tramo preparado por el hilo lector
+     * @return false si no quedan tramos; relanza el error del hilo si lo hubo
+     */
+    bool siguienteTramo(int k) {
+        if (colaTramos && kTuberia != k) {
+            // con otro k los tramos ya cortados no sirven: se vuelve a leer desde el inicio
+            detenerTuberia();
+            fuente->reset();
+        }
+        if (!colaTramos) iniciarTuberia(k);
+
+        TramoAnticipado siguiente;
+        tramo = DatosArchivo{nullptr, nullptr, 0};
+        currentPosition = 0;
+        reiniciarVentanas();
+        if (!colaTramos->pop(siguiente)) {
+            if (errorProductor) std::rethrow_exception(errorProductor);
+            return false;
+        }
+        tramo = siguiente.datos;
+        extractorMulti.acotar(tramo.solape); // los k-mers menores del solape ya salieron del tramo anterior
+        currentFileIndex = siguiente.indiceArchivo;
+        currentFilename = fastaFiles[currentFileIndex];
+        return true;
+    }
+
+    static bool esArchivoRegular(const std::string& filename) {
+        return filename != "-" && std::filesystem::is_regular_file(filename);
+    }
+
+    static bool terminaEn(const std::string& texto, const std::string& sufijo) {
+        return texto.size() >= sufijo.size() &&
+               texto.compare(texto.size() - sufijo.size(), sufijo.size(), sufijo) == 0;
+    }
+
+    static bool esComprimido(const std::string& filename) {
+        return terminaEn(filename, ".gz");
+    }
+
+    // extensiones .fna, .fa y .fasta, opcionalmente comprimidas con gzip
+    static bool esNombreFasta(const std::string& filename) {
+        std::string base = esComprimido(filename) ? filename.substr(0, filename.size() - 3) : filename;
+        return terminaEn(base, ".fna") || terminaEn(base, ".fa") || terminaEn(base, ".fasta");
+    }
+
+    // extensiones .fq y .fastq, opcionalmente comprimidas con gzip
+    static bool esNombreFastq(const std::string& filename) {
+        std::string base = esComprimido(filename) ? filename.substr(0, filename.size() - 3) : filename;
+        return terminaEn(base, ".fq") || terminaEn(base, ".fastq");
+    }
+
+    // un archivo regular sin comprimir cuyo primer carácter es '@' es un FASTQ
+    static bool empiezaComoFastq(const std::string& filename) {
+        if (!esArchivoRegular(filename) || esComprimido(filename)) return false;
+        std::ifstream file(filename, std::ios::binary);
+        return file.get() == '@';
+    }
+
+    // lee el siguiente bloque del flujo; reutiliza el buffer si nadie más lo tiene
+    bool recargarBloque() {
+        if (!bloque || bloque.use_count() > 1) {
+            bloque = std::shared_ptr<char[]>(new char[RESERVA_COLA + TAMANO_BLOQUE]);
+        }
+        largoBloque = flujo->leer(bloque.get() + RESERVA_COLA, TAMANO_BLOQUE);
+        currentPosition = 0;
+        bloquesLeidos++;
+        return largoBloque > 0;
+    }
+
+    /**
+     * Entrega lo que queda del bloque actual como texto que un ExtractorKmers nuevo puede
+     * recorrer por sí solo: se le antepone la cola (k-1 bases) del bloque anterior o, si
+     * este terminó en una cabecera, se salta el resto de ella. Puede quedar vacío.
+     */
+    DatosArchivo bloqueAutocontenido(int k) {
+        char* inicio = bloque.get() + RESERVA_COLA + currentPosition;
+        size_t largo = largoBloque - currentPosition;
+        EstadoBloque anterior = estadoFlujo;
+        avanzarEstado(estadoFlujo, inicio, largo, k - 1);
+        currentPosition = largoBloque;
+
+        if (anterior.enCabecera) {
+            const char* finLinea = static_cast<const char*>(std::memchr(inicio, '\n', largo));
+            if (finLinea == nullptr) return DatosArchivo{nullptr, nullptr, 0};
+            largo -= finLinea + 1 - inicio;
+            inicio += finLinea + 1 - inicio;
+        } else {
+            inicio -= anterior.cola.size();
+            largo += anterior.cola.size();
+            std::memcpy(inicio, anterior.cola.data(), anterior.cola.size());
+        }
+        return DatosArchivo{bloque, inicio, largo, anterior.cola.size()};
+    }
+
+    // los métodos que devuelven texto de la secuencia necesitan la secuencia limpia en memoria
+    void requiereCompleto(const char* metodo) const {
+        if (modo != ModoLectura::Completo || anticipada || flujo) {
+            throw std::logic_error(std::string(metodo) + " requiere ModoLectura::Completo sin lectura anticipada"
+                                   " ni archivos comprimidos o FASTQ");
+        }
+    }
 
 public:
     /**
      * Constructor que carga todos los archivos FASTA de un directorio
-     * @param directory Ruta al directorio que contiene archivos FASTA
+     * @param directory Ruta al directorio que contiene archivos FASTA, a un único archivo o
+     *                  tubería, o "-" para la entrada estándar
+     * @param modo Forma de cargar cada archivo (ver ModoLectura)
+     * @param anticipada Si es true, un hilo lector prepara los tramos siguientes (archivos
+     *                   completos, o bloques en ModoLectura::Flujo) mientras se procesan los
+     *                   actuales, de modo que la lectura no detiene la extracción de k-mers
+     * @param calidadMinima En archivos FASTQ, las bases con calidad Phred menor se tratan
+     *                      como 'N' (0 = no se enmascara ninguna)
      */
-    LectorGenomas(const std::string& directory = "Genomas") 
-        : currentPosition(0), currentFileIndex(0), genomasDirectory(directory) {
+    LectorGenomas(const std::string& directory = "Genomas", ModoLectura modo = ModoLectura::Completo,
+                  bool anticipada = false, int calidadMinima = 0) 
+        : currentPosition(0), currentFileIndex(0), genomasDirectory(directory), modo(modo),
+          largoBloque(0), bloquesLeidos(0), entradaEstandarLeida(false), hilosDescompresion(0),
+          calidadMinima(calidadMinima), anticipada(anticipada), kTuberia(0) {
         loadFastaDirectory(directory);
         if (!fastaFiles.empty()) {
             loadCurrentFile();
         }
     }
 
+    LectorGenomas(const LectorGenomas&) = delete;
+    LectorGenomas& operator=(const LectorGenomas&) = delete;
+
+    ~LectorGenomas() {
+        detenerTuberia();
+    }
+
     /**
      * Carga la lista de archivos FASTA de un directorio
      * @param directory Ruta al directorio que contiene archivos FASTA
@@ -41,18 +293,22 @@ public:
     void loadFastaDirectory(const std::string& directory) {
         fastaFiles.clear();
         
-        if (!std::filesystem::exists(directory)) {
+        if (directory != "-" && !std::filesystem::exists(directory)) {
             throw std::runtime_error("El directorio no existe: " + directory);
         }
+
+        // Un archivo, una tubería o la entrada estándar se leen como única entrada
+        if (directory == "-" || !std::filesystem::is_directory(directory)) {
+            fastaFiles.push_back(directory);
+            std::cout << "Leyendo " << (directory == "-" ? "la entrada estándar" : directory) << std::endl;
+            return;
+        }
         
         for (const auto& entry : std::filesystem::directory_iterator(directory)) {
             if (entry.is_regular_file()) {
                 std::string filename = entry.path().string();
-                // Verificar que sea un archivo FASTA (extensiones .fna, .fa, .fasta)
-                if (filename.size() >= 4 && 
-                    (filename.substr(filename.size() - 4) == ".fna" ||
-                     filename.substr(filename.size() - 3) == ".fa" ||
-                     (filename.size() >= 6 && filename.substr(filename.size() - 6) == ".fasta"))) {
+                // Verificar que sea un archivo FASTA (.fna, .fa, .fasta) o FASTQ (.fq, .fastq), o sus .gz
+                if (esNombreFasta(filename) || esNombreFastq(filename)) {
                     fastaFiles.push_back(filename);
                 }
             }
@@ -62,7 +318,7 @@ public:
             throw std::runtime_error("No se encontraron archivos FASTA en el directorio: " + directory);
         }
         
-        std::cout << "Se encontraron " << fastaFiles.size() << " archivos FASTA en " << directory << std::endl;
+        std::cout << "Se encontraron " << fastaFiles.size() << " archivos FASTA/FASTQ en " << directory << std::endl;
     }
 
     /**
@@ -74,29 +330,106 @@ public:
         }
         
         currentFilename = fastaFiles[currentFileIndex];
-        loadFastaFile(currentFilename);
+        if (anticipada) {
+            // el archivo lo carga el lector interno; los tramos se piden al extraer k-mers
+            detenerTuberia();
+            if (!fuente) {
+                fuente.reset(new LectorGenomas(fastaFiles, genomasDirectory, modo, calidadMinima)); // ya carga el primero
+            } else {
+                fuente->currentFileIndex = currentFileIndex;
+                fuente->loadCurrentFile();
+            }
+            tramo = DatosArchivo{nullptr, nullptr, 0};
+            currentPosition = 0;
+            reiniciarVentanas();
+            return;
+        }
+        if (currentFilename == "-") {
+            if (entradaEstandarLeida) {
+                throw std::runtime_error("La entrada estándar solo puede leerse una vez");
+            }
+            entradaEstandarLeida = true;
+        }
+
+        genomicData.clear();
+        mapa.reset();
+        flujo.reset();
+        largoBloque = 0;
+        bloquesLeidos = 0;
+        estadoFlujo = EstadoBloque();
+        bool fastq = esNombreFastq(currentFilename) || empiezaComoFastq(currentFilename);
+        if (fastq || esComprimido(currentFilename) || modo == ModoLectura::Flujo ||
+            (modo == ModoLectura::Mapeado && !esArchivoRegular(currentFilename))) {
+            if (esComprimido(currentFilename)) {
+                flujo.reset(new FlujoGzip(currentFilename, hilosDescompresion));
+            } else {
+                flujo.reset(new FlujoBloques(currentFilename));
+            }
+            if (fastq) {
+                flujo.reset(new FlujoFastq(std::move(flujo), calidadMinima));
+            }
+            if (!recargarBloque()) {
+                throw std::runtime_error("El archivo no contiene datos genómicos válidos");
+            }
+            if (!fastq && bloque[RESERVA_COLA] == '@') {
+                // FASTQ que no se pudo reconocer antes de leerlo (entrada estándar, tubería, .gz)
+                flujo.reset(new FlujoFastq(std::move(flujo), calidadMinima, bloque.get() + RESERVA_COLA, largoBloque));
+                bloquesLeidos = 0;
+                if (!recargarBloque()) {
+                    throw std::runtime_error("El archivo no contiene datos genómicos válidos");
+                }
+            }
+        } else if (modo == ModoLectura::Mapeado) {
+            mapa = std::make_shared<const ArchivoMapeado>(currentFilename);
+            if (mapa->size() == 0) {
+                throw std::runtime_error("El archivo no contiene datos genómicos válidos");
+            }
+        } else {
+            loadFastaFile(currentFilename);
+        }
         currentPosition = 0;
+        reiniciarVentanas();
     }
 
     /**
      * Carga el contenido del archivo FASTA, omitiendo las líneas de cabecera
-     * @param filename Ruta al archivo FASTA
+     * Los registros se separan con SEPARADOR_REGISTROS para que ningún k-mer los cruce
+     * @param filename Ruta al archivo FASTA, o "-" para la entrada estándar
      */
     void loadFastaFile(const std::string& filename) {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            throw std::runtime_error("No se pudo abrir el archivo: " + filename);
+        std::ifstream file;
+        if (filename != "-") {
+            file.open(filename);
+            if (!file.is_open()) {
+                throw std::runtime_error("No se pudo abrir el archivo: " + filename);
+            }
         }
+        std::istream& entrada = (filename == "-") ? std::cin : file;
 
         std::string line;
         genomicData.clear();
+        bool nuevoRegistro = false;
         
-        while (std::getline(file, line)) {
-            // Saltamos las líneas que empiezan con '>'
-            if (!line.empty() && line[0] != '>') {
+        while (std::getline(entrada, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            // Lo que sigue a '>' es cabecera hasta el fin de línea
+            size_t cabecera = line.find('>');
+            if (cabecera != std::string::npos) {
+                line.resize(cabecera);
+            }
+            if (!line.empty()) {
+                if (nuevoRegistro && !genomicData.empty()) {
+                    genomicData += SEPARADOR_REGISTROS;
+                }
+                nuevoRegistro = false;
                 // Concatenamos la línea eliminando saltos de línea
                 genomicData += line;
             }
+            if (cabecera != std::string::npos) {
+                nuevoRegistro = true;
+            }
         }
         
         file.close();
@@ -110,10 +443,12 @@ public:
      * Extrae un k-mer de longitud k desde la posición actual
      * Avanza la posición actual en 1 después de cada llamada
      * Si se acaba el archivo actual, automáticamente pasa al siguiente
+     * Solo disponible en ModoLectura::Completo
      * @param k Longitud del k-mer a extraer
      * @return String con el k-mer extraído, o string vacío si no hay más k-mers en ningún archivo
      */
     std::string getNextKmer(int k) {
+        requiereCompleto("getNextKmer");
         if (k <= 0) {
             throw std::invalid_argument("El valor de k debe ser mayor que 0");
         }
@@ -135,11 +470,147 @@ public:
     }
 
     /**
-     * Reinicia la posición actual al inicio de la secuencia
+     * Extrae el siguiente k-mer canónico empaquetado en 2 bits, sin reservar memoria
+     * Mantiene una ventana deslizante que se actualiza en O(1) por base y omite
+     * los k-mers con bases distintas de ACGT. Si se acaba el archivo actual,
+     * automáticamente pasa al siguiente.
+     * No debe mezclarse con getNextKmer sin llamar antes a reset().
+     * @param k Longitud del k-mer (1 a 32)
+     * @param kmer Donde se escribe el k-mer canónico
+     * @return true si se extrajo un k-mer, false si no quedan en ningún archivo
+     */
+    bool getNextCanonicalKmer(int k, uint64_t& kmer) {
+        return getNextCanonicalKmers(k, &kmer, 1) == 1;
+    }
+
+    /**
+     * Extrae hasta max k-mers canónicos empaquetados de una vez (ver getNextCanonicalKmer)
+     * Pensado para alimentar insertBatch de los sketches.
+     * @param k Longitud del k-mer (1 a 32)
+     * @param kmers Arreglo de salida con espacio para max elementos
+     * @param max Máximo de k-mers a extraer
+     * @return Número de k-mers escritos; 0 si no quedan en ningún archivo
+     */
+    size_t getNextCanonicalKmers(int k, uint64_t* kmers, size_t max) {
+        if (extractor.getK() != k) {
+            extractor = ExtractorKmers(k);
+        }
+
+        size_t n = 0;
+        while (n < max) {
+            n += extractor.extraer(datosActuales(), largoActual(), currentPosition, kmers + n, max - n);
+            if (n == max) {
+                break;
+            }
+            if (anticipada) {
+                if (siguienteTramo(k)) continue;
+                break;
+            }
+            if (flujo && recargarBloque()) {
+                continue;
+            }
+            if (!hasMoreFiles()) {
+                break;
+            }
+            nextFile();
+        }
+        return n;
+    }
+
+    /**
+     * Extrae en una sola pasada los k-mers canónicos de varios k (ver getNextCanonicalKmers)
+     * La entrada se lee y se recorre una vez; cada k-mer de ks[i] se escribe en kmers[i].
+     * No debe mezclarse con la versión de un solo k sin llamar antes a reset().
+     * @param ks Longitudes de k-mer (1 a 32)
+     * @param kmers kmers[i] es el arreglo de salida de ks[i], con espacio para max elementos
+     * @param n Donde se escribe cuántos k-mers quedaron en cada kmers[i]
+     * @param max Máximo de k-mers por cada k; se retorna cuando alguno se llena
+     * @return Número de k-mers escritos en total; 0 si no quedan en ningún archivo
+     */
+    size_t getNextCanonicalKmers(const std::vector<int>& ks, uint64_t* const* kmers, size_t* n, size_t max) {
+        if (extractorMulti.getKs() != ks) {
+            extractorMulti = ExtractorMultiK(ks);
+        }
+        std::fill(n, n + ks.size(), 0);
+
+        size_t total = 0;
+        while (true) {
+            total += extractorMulti.extraer(datosActuales(), largoActual(), currentPosition, kmers, n, max);
+            if (currentPosition < largoActual()) {
+                break; // se llenó algún lote
+            }
+            if (anticipada) {
+                if (siguienteTramo(extractorMulti.getKMax())) continue;
+                break;
+            }
+            if (flujo && recargarBloque()) {
+                continue;
+            }
+            if (!hasMoreFiles()) {
+                break;
+            }
+            nextFile();
+        }
+        return total;
+    }
+
+    /**
+     * Entrega el siguiente tramo de la entrada como texto independiente, sin copiar la
+     * secuencia, y avanza de archivo cuando se agota. Usado por la ingesta paralela.
+     * En ModoLectura::Flujo cada tramo es un bloque con la cola de k-1 bases del anterior
+     * antepuesta (tramo.solape); en los otros modos es el archivo completo (ver extraerDatos).
+     * Para varios k se pide el mayor, y los k-mers menores que terminan dentro del solape
+     * se descartan porque ya están en el tramo anterior.
+     * No debe mezclarse con getNextCanonicalKmers sin llamar antes a reset().
+     * @param k Longitud del k-mer que se extraerá de los tramos
+     * @param tramo Donde se escribe el tramo
+     * @return false si ya no quedan datos en ningún archivo
+     */
+    bool extraerBloque(int k, DatosArchivo& tramo) {
+        if (anticipada) {
+            if (!siguienteTramo(k)) return false;
+            tramo = this->tramo;
+            currentPosition = this->tramo.largo;
+            return true;
+        }
+        while (true) {
+            if (flujo) {
+                while (currentPosition < largoBloque || recargarBloque()) {
+                    tramo = bloqueAutocontenido(k);
+                    if (tramo.largo > 0) return true;
+                }
+            } else if (largoActual() > 0) {
+                tramo = extraerDatos();
+                return true;
+            }
+            if (!hasMoreFiles()) {
+                return false;
+            }
+            nextFile();
+        }
+    }
+
+    /**
+     * Reinicia la lectura al inicio del primer archivo
+     * Una entrada por bloques se vuelve a abrir salvo que aún esté en su primer bloque
      */
     void reset() {
-        currentFileIndex = 0;
+        if (anticipada) {
+            detenerTuberia();
+            fuente->reset();
+            currentFileIndex = 0;
+            currentFilename = fastaFiles[0];
+            tramo = DatosArchivo{nullptr, nullptr, 0};
+            currentPosition = 0;
+            reiniciarVentanas();
+            return;
+        }
+        if (currentFileIndex != 0 || largoActual() == 0 || bloquesLeidos > 1) {
+            currentFileIndex = 0;
+            loadCurrentFile();
+        }
         currentPosition = 0;
+        reiniciarVentanas();
     }
 
     /**
@@ -152,10 +623,10 @@ public:
 
     /**
      * Obtiene la longitud total de la secuencia genómica
-     * @return Longitud en nucleótidos
+     * @return Longitud en nucleótidos; en los otros modos, bytes cargados incluyendo cabeceras
      */
     size_t getSequenceLength() const {
-        return genomicData.length();
+        return largoActual();
     }
 
     /**
@@ -166,13 +637,71 @@ public:
      */
     bool hasMoreKmers(int k) const {
         // Hay k-mers en el archivo actual
-        if (currentPosition + k <= genomicData.length()) {
+        if (currentPosition + k <= largoActual()) {
             return true;
         }
         // O hay más archivos disponibles
         return hasMoreFiles();
     }
 
+    /**
+     * Entrega la secuencia del archivo actual sin copiarla, dejando el lector sin datos
+     * hasta el próximo nextFile() o reset(). Solo disponible en ModoLectura::Completo.
+     * @return Secuencia completa del archivo actual
+     */
+    std::string extraerSecuencia() {
+        requiereCompleto("extraerSecuencia");
+        std::string secuencia = std::move(genomicData);
+        genomicData.clear();
+        currentPosition = 0;
+        reiniciarVentanas();
+        return secuencia;
+    }
+
+    /**
+     * Entrega los bytes del archivo actual sin copiarlos, dejando el lector sin datos
+     * hasta el próximo nextFile() o reset(). Usado por la ingesta paralela.
+     * En ModoLectura::Completo es la secuencia limpia; en Mapeado, el FASTA crudo con
+     * cabeceras y saltos de línea, que se recorre con ExtractorKmers. Una entrada leída
+     * por bloques no puede entregarse completa; ver extraerBloque.
+     */
+    DatosArchivo extraerDatos() {
+        if (anticipada) {
+            throw std::logic_error("extraerDatos no está disponible con lectura anticipada; usar extraerBloque");
+        }
+        if (flujo) {
+            throw std::logic_error("extraerDatos no está disponible al leer por bloques; usar extraerBloque");
+        }
+        DatosArchivo resultado;
+        if (mapa) {
+            resultado = DatosArchivo{mapa, mapa->data(), mapa->size()};
+            mapa.reset();
+        } else {
+            auto secuencia = std::make_shared<const std::string>(extraerSecuencia());
+            resultado = DatosArchivo{secuencia, secuencia->data(), secuencia->size(), 0, true};
+        }
+        currentPosition = 0;
+        reiniciarVentanas();
+        return resultado;
+    }
+
+    ModoLectura getModo() const {
+        return modo;
+    }
+
+    bool usaLecturaAnticipada() const {
+        return anticipada;
+    }
+
+    /**
+     * Hilos con que se descomprimen los archivos BGZF abiertos desde ahora (0 = todos los núcleos)
+     * Con lectura anticipada la descompresión ocurre en el hilo lector y sus ayudantes.
+     */
+    void setHilosDescompresion(int hilos) {
+        hilosDescompresion = hilos;
+        if (fuente) fuente->setHilosDescompresion(hilos);
+    }
+
     /**
      * Obtiene un fragmento de la secuencia sin avanzar la posición
      * @param start Posición de inicio
@@ -180,6 +709,7 @@ public:
      * @return String con el fragmento solicitado
      */
     std::string getSequenceFragment(size_t start, size_t length) const {
+        requiereCompleto("getSequenceFragment");
         if (start + length > genomicData.length()) {
             throw std::out_of_range("El fragmento solicitado excede la longitud de la secuencia");
         }
@@ -193,8 +723,12 @@ public:
         std::cout << "=== Información del archivo FASTA ===" << std::endl;
         std::cout << "Archivo actual: " << currentFilename << std::endl;
         std::cout << "Archivo " << (currentFileIndex + 1) << " de " << fastaFiles.size() << std::endl;
-        std::cout << "Longitud de la secuencia: " << genomicData.length() << " nucleótidos" << std::endl;
         std::cout << "Posición actual: " << currentPosition << std::endl;
+        if (modo != ModoLectura::Completo || flujo) {
+            std::cout << "Bytes cargados del archivo: " << largoActual() << std::endl;
+            return;
+        }
+        std::cout << "Longitud de la secuencia: " << genomicData.length() << " nucleótidos" << std::endl;
         std::cout << "Primeros 50 nucleótidos: " << genomicData.substr(0, 50) << "..." << std::endl;
     }
 
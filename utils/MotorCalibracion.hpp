@@ -0,0 +1,180 @@
+#ifndef MOTORCALIBRACION_H
+#define MOTORCALIBRACION_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "ColaAcotada.hpp"
+#include "LectorGenomas.hpp"
+#include "../sketchs/mixhash64.hpp"
+
+/**
+ * Llena una grilla completa de sketches en una sola pasada por los genomas
+ *
+ * En vez de releer los genomas una vez por configuración, el hilo que llama a ejecutar()
+ * lee los k-mers en bloques de TAMANO_BLOQUE, calcula una sola vez el HashFilas de cada
+ * k-mer para cada semilla distinta de la grilla y reparte el bloque, de solo lectura, a
+ * los hilos trabajadores por colas acotadas. Cada trabajador es dueño de un subconjunto
+ * fijo de sketches (repartidos por costo) y los actualiza con el hash ya calculado, así
+ * que no hay sincronización sobre los contadores y el tiempo crece con las actualizaciones
+ * de memoria de los sketches, no con el tamaño de la grilla por el de la entrada.
+ */
+class MotorCalibracion
+{
+public:
+    static const size_t TAMANO_BLOQUE = 1 << 16;
+    static const size_t BLOQUES_EN_COLA = 4;   // por trabajador
+
+private:
+    struct Bloque {
+        std::vector<uint64_t> kmers;
+        std::vector<std::vector<HashFilas>> hashes;    // uno por semilla
+    };
+
+    // Actualiza un sketch con los k-mers de un bloque y el hash de su semilla
+    using Actualizar = std::function<void(const uint64_t*, const HashFilas*, size_t)>;
+
+    struct Punto {
+        Actualizar actualizar;
+        size_t semilla;     // índice en semillas
+        double costo;
+        double segundos = 0.0;
+    };
+
+    std::vector<uint64_t> semillas;
+    std::vector<Punto> puntos;
+
+    size_t indiceSemilla(uint64_t semilla) {
+        auto it = std::find(semillas.begin(), semillas.end(), semilla);
+        if (it != semillas.end()) return it - semillas.begin();
+        semillas.push_back(semilla);
+        return semillas.size() - 1;
+    }
+
+    // Reparte los puntos entre hilos, el más costoso primero al trabajador menos cargado
+    std::vector<std::vector<size_t>> repartir(int hilos) const {
+        std::vector<size_t> orden(puntos.size());
+        for (size_t i = 0; i < orden.size(); i++) orden[i] = i;
+        std::stable_sort(orden.begin(), orden.end(),
+                         [&](size_t a, size_t b) { return puntos[a].costo > puntos[b].costo; });
+        std::vector<std::vector<size_t>> asignados(hilos);
+        std::vector<double> carga(hilos, 0.0);
+        for (size_t i : orden) {
+            int h = (int)(std::min_element(carga.begin(), carga.end()) - carga.begin());
+            asignados[h].push_back(i);
+            carga[h] += puntos[i].costo;
+        }
+        return asignados;
+    }
+
+public:
+    /**
+     * Agrega un sketch a la grilla; debe seguir vivo hasta que termine ejecutar()
+     * @param semilla Semilla con que actualizar espera los HashFilas (getSemilla() del sketch)
+     * @param costo Peso relativo de sus actualizaciones, para repartir los sketches entre hilos
+     * @param actualizar Función actualizar(kmers, hashes, n)
+     * @return Índice del sketch, para getSegundos()
+     */
+    size_t agregar(uint64_t semilla, double costo, Actualizar actualizar) {
+        puntos.push_back({std::move(actualizar), indiceSemilla(semilla), costo});
+        return puntos.size() - 1;
+    }
+
+    // Sketches con insertBatch(const HashFilas*, n), como CountSketch y CountSketchBloques
+    template<typename Sketch>
+    size_t agregar(Sketch &sketch, double costo) {
+        return agregar(sketch.getSemilla(), costo, [&sketch](const uint64_t*, const HashFilas *hashes, size_t n) {
+            sketch.insertBatch(hashes, n);
+        });
+    }
+
+    /**
+     * Recorre todos los k-mers del lector una vez y actualiza todos los sketches
+     * @param k Longitud del k-mer
+     * @param hilos Trabajadores que actualizan los sketches (a lo más uno por sketch)
+     * @param ademas Si no es nula, se llama ademas(kmers, n) con cada bloque desde el hilo
+     *               lector, por ejemplo para llenar el conteo exacto en la misma pasada
+     * @return Total de k-mers recorridos
+     */
+    long long ejecutar(LectorGenomas &lector, int k, int hilos,
+                       std::function<void(const uint64_t*, size_t)> ademas = nullptr) {
+        hilos = std::max(1, std::min(hilos, (int)puntos.size()));
+        std::vector<std::vector<size_t>> asignados = repartir(hilos);
+        for (Punto &p : puntos) p.segundos = 0.0;
+
+        std::vector<std::unique_ptr<ColaAcotada<std::shared_ptr<const Bloque>>>> colas;
+        for (int h = 0; h < hilos; h++) {
+            colas.emplace_back(new ColaAcotada<std::shared_ptr<const Bloque>>(BLOQUES_EN_COLA));
+        }
+        std::vector<std::exception_ptr> errores(hilos);
+        std::vector<std::thread> trabajadores;
+        for (int h = 0; h < hilos; h++) {
+            trabajadores.emplace_back([&, h]() {
+                try {
+                    std::shared_ptr<const Bloque> bloque;
+                    while (colas[h]->pop(bloque)) {
+                        for (size_t i : asignados[h]) {
+                            Punto &p = puntos[i];
+                            auto inicio = std::chrono::steady_clock::now();
+                            p.actualizar(bloque->kmers.data(), bloque->hashes[p.semilla].data(), bloque->kmers.size());
+                            p.segundos += std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+                        }
+                    }
+                } catch (...) {
+                    errores[h] = std::current_exception();
+                    colas[h]->cerrar(); // el lector deja de esperarlo
+                }
+            });
+        }
+
+        long long total = 0;
+        std::exception_ptr errorLector;
+        try {
+            lector.reset();
+            while (true) {
+                std::shared_ptr<Bloque> bloque = std::make_shared<Bloque>();
+                bloque->kmers.resize(TAMANO_BLOQUE);
+                size_t n = 0, leidos;
+                while (n < TAMANO_BLOQUE &&
+                       (leidos = lector.getNextCanonicalKmers(k, bloque->kmers.data() + n, TAMANO_BLOQUE - n)) > 0) {
+                    n += leidos;
+                }
+                if (n == 0) break;
+                bloque->kmers.resize(n);
+                bloque->hashes.resize(semillas.size());
+                for (size_t s = 0; s < semillas.size(); s++) {
+                    std::vector<HashFilas> &hashes = bloque->hashes[s];
+                    hashes.reserve(n);
+                    for (size_t i = 0; i < n; i++) hashes.emplace_back(bloque->kmers[i], semillas[s]);
+                }
+                if (ademas) ademas(bloque->kmers.data(), n);
+                total += n;
+
+                std::shared_ptr<const Bloque> compartido = std::move(bloque);
+                for (auto &cola : colas) cola->push(compartido);
+            }
+        } catch (...) {
+            errorLector = std::current_exception();
+        }
+        for (auto &cola : colas) cola->cerrar();
+        for (std::thread &t : trabajadores) t.join();
+        if (errorLector) std::rethrow_exception(errorLector);
+        for (std::exception_ptr &e : errores) {
+            if (e) std::rethrow_exception(e);
+        }
+        return total;
+    }
+
+    // Segundos que tomaron las actualizaciones del sketch i en la última ejecución
+    double getSegundos(size_t i) const { return puntos[i].segundos; }
+
+    size_t size() const { return puntos.size(); }
+};
+
+#endif // MOTORCALIBRACION_H
@@ -0,0 +1,106 @@
+#ifndef OPCIONESEJECUCION_H
+#define OPCIONESEJECUCION_H
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "LectorGenomas.hpp"
+
+/**
+ * Opciones de línea de comandos comunes a los programas de la raíz
+ *   --hilos N     número de hilos de ingesta (0 = todos los disponibles, por defecto 1)
+ *   --verificar   con más de un hilo, compara el resultado contra una pasada secuencial
+ *   --lector M    forma de cargar los archivos: mapeado (por defecto), completo o flujo (ver ModoLectura)
+ *   --entrada R   directorio de genomas, un archivo FASTA o "-" para la entrada estándar (por defecto Genomas)
+ *   --sin-anticipar  lee en el mismo hilo que extrae, sin el hilo de lectura anticipada
+ *   --calidad-minima Q  en lecturas FASTQ, descarta los k-mers con alguna base de calidad Phred menor que Q
+ *   --particiones N  (ground_truth) cuenta en dos fases con N particiones en disco por k; 0 = en memoria
+ *   --temporal DIR   (ground_truth) directorio de las particiones (por defecto particiones_tmp)
+ *   --conteo M       (ground_truth) conteo exacto en memoria: tabla (ContadorExacto, por defecto) u orden (ContadorOrdenado)
+ *   --muestra F      (calibracion_sketchs) evalúa el error sobre una fracción F de los k-mers distintos (por defecto 1)
+ *   --guardar DIR    (calcular_cs, calcular_ts) guarda cada sketch en DIR/<sketch>_<k>mer.sketch (ver archivosketch.hpp)
+ */
+struct OpcionesEjecucion {
+    int hilos = 1;
+    bool verificar = false;
+    ModoLectura modoLectura = ModoLectura::Mapeado;
+    std::string entrada = "Genomas";
+    bool lecturaAnticipada = true;
+    int calidadMinima = 0;
+    int particiones = 0;
+    std::string directorioTemporal = "particiones_tmp";
+    bool conteoOrdenado = false;
+    double muestra = 1.0;
+    std::string directorioSketches;     // vacío = no guardar
+};
+
+inline void mostrarUso(const std::string& programa) {
+    std::cout << "Uso: " << programa << " [--hilos N] [--verificar] [--lector mapeado|completo|flujo] [--entrada RUTA] [--sin-anticipar] [--calidad-minima Q] [--particiones N] [--temporal DIR] [--conteo tabla|orden] [--muestra F] [--guardar DIR]" << std::endl;
+}
+
+/**
+ * Interpreta argv; lanza std::invalid_argument ante una opción desconocida o mal formada
+ */
+inline OpcionesEjecucion leerOpciones(int argc, char* argv[]) {
+    OpcionesEjecucion opciones;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--hilos" && i + 1 < argc) {
+            opciones.hilos = std::stoi(argv[++i]);
+            if (opciones.hilos < 0) {
+                throw std::invalid_argument("--hilos debe ser >= 0");
+            }
+        } else if (arg == "--verificar") {
+            opciones.verificar = true;
+        } else if (arg == "--lector" && i + 1 < argc) {
+            std::string modo = argv[++i];
+            if (modo == "mapeado") {
+                opciones.modoLectura = ModoLectura::Mapeado;
+            } else if (modo == "completo") {
+                opciones.modoLectura = ModoLectura::Completo;
+            } else if (modo == "flujo") {
+                opciones.modoLectura = ModoLectura::Flujo;
+            } else {
+                throw std::invalid_argument("--lector debe ser mapeado, completo o flujo");
+            }
+        } else if (arg == "--entrada" && i + 1 < argc) {
+            opciones.entrada = argv[++i];
+        } else if (arg == "--sin-anticipar") {
+            opciones.lecturaAnticipada = false;
+        } else if (arg == "--calidad-minima" && i + 1 < argc) {
+            opciones.calidadMinima = std::stoi(argv[++i]);
+            if (opciones.calidadMinima < 0 || opciones.calidadMinima > 93) {
+                throw std::invalid_argument("--calidad-minima debe estar entre 0 y 93");
+            }
+        } else if (arg == "--particiones" && i + 1 < argc) {
+            opciones.particiones = std::stoi(argv[++i]);
+            if (opciones.particiones < 0) {
+                throw std::invalid_argument("--particiones debe ser >= 0");
+            }
+        } else if (arg == "--temporal" && i + 1 < argc) {
+            opciones.directorioTemporal = argv[++i];
+        } else if (arg == "--conteo" && i + 1 < argc) {
+            std::string motor = argv[++i];
+            if (motor == "tabla") {
+                opciones.conteoOrdenado = false;
+            } else if (motor == "orden") {
+                opciones.conteoOrdenado = true;
+            } else {
+                throw std::invalid_argument("--conteo debe ser tabla u orden");
+            }
+        } else if (arg == "--muestra" && i + 1 < argc) {
+            opciones.muestra = std::stod(argv[++i]);
+            if (!(opciones.muestra > 0.0 && opciones.muestra <= 1.0)) {
+                throw std::invalid_argument("--muestra debe estar en (0, 1]");
+            }
+        } else if (arg == "--guardar" && i + 1 < argc) {
+            opciones.directorioSketches = argv[++i];
+        } else {
+            mostrarUso(argv[0]);
+            throw std::invalid_argument("Opción desconocida: " + arg);
+        }
+    }
+    return opciones;
+}
+
+#endif // OPCIONESEJECUCION_H
@@ -0,0 +1,372 @@
+#ifndef PARTICIONMINIMIZADORES_H
+#define PARTICIONMINIMIZADORES_H
+
+#include "LectorGenomas.hpp"
+#include "IngestaParalela.hpp"
+#include "ArchivoMapeado.hpp"
+#include "CodificadorKmers.hpp"
+#include "ExtractorKmers.hpp"
+#include "../sketchs/mixhash64.hpp"
+#include "../sketchs/contadorexacto.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Arma los super-k-mers de una secuencia: tramos de k-mers consecutivos con el mismo minimizador
+ *
+ * El minimizador de un k-mer es el menor mixhash64 de sus m-mers canónicos, así que un k-mer
+ * y su reverso complementario tienen el mismo y caen en la misma partición. Los hashes de
+ * los m-mers de la ventana se mantienen en una cola monótona, de modo que cada base cuesta
+ * O(1) amortizado. Un super-k-mer de s k-mers se guarda con k + s - 1 bases en vez de s
+ * claves de 8 bytes.
+ */
+class ConstructorSuperKmers {
+private:
+    int k;
+    KmerRodante rodanteM;                               // m-mer canónico que entra a la ventana
+    std::string bases;                                  // bases del segmento desde inicioBases
+    size_t inicioBases;
+    size_t vistas;                                      // bases del segmento
+    std::deque<std::pair<uint64_t, size_t>> ventana;    // (hash, inicio) de m-mers, hashes crecientes
+    bool hayActual;
+    uint64_t minimoActual;
+    size_t inicioActual;                                // primera base del super-k-mer en curso
+    long long kmers;                                    // k-mers entregados en super-k-mers
+
+    template<typename Salida>
+    void entregar(size_t fin, Salida& salida) {
+        if (hayActual) {
+            salida(minimoActual, bases.data() + (inicioActual - inicioBases), fin - inicioActual);
+            hayActual = false;
+        }
+    }
+
+    // descarta las bases anteriores a desde
+    void recortar(size_t desde) {
+        if (desde > inicioBases) {
+            bases.erase(0, desde - inicioBases);
+            inicioBases = desde;
+        }
+    }
+
+public:
+    ConstructorSuperKmers(int k, int m)
+        : k(k), rodanteM(m), inicioBases(0), vistas(0), hayActual(false), minimoActual(0),
+          inicioActual(0), kmers(0) {
+        KmerRodante validar(k);
+        if (m > k) {
+            throw std::invalid_argument("El largo del minimizador no puede superar k");
+        }
+    }
+
+    /**
+     * Agrega una base válida del segmento en curso
+     * @param emitir false si el k-mer que termina en esta base no le corresponde (solape)
+     */
+    template<typename Salida>
+    void agregar(char c, uint8_t codigo, bool emitir, Salida& salida) {
+        size_t t = vistas++;
+        bases.push_back(c);
+        if (rodanteM.pushCodigo(codigo)) {
+            uint64_t h = mixhash64(rodanteM.getCanonico(), 0);
+            while (!ventana.empty() && ventana.back().first >= h) ventana.pop_back();
+            ventana.emplace_back(h, t + 1 - rodanteM.getK());
+        }
+        if (t + 1 < (size_t)k) return;
+
+        size_t inicioKmer = t + 1 - k;
+        while (ventana.front().second < inicioKmer) ventana.pop_front();
+        uint64_t minimo = ventana.front().first;
+
+        if (!emitir) {
+            entregar(t, salida);
+            recortar(inicioKmer + 1);
+            return;
+        }
+        if (hayActual && minimo == minimoActual) {
+            kmers++;
+            return;
+        }
+        entregar(t, salida);
+        recortar(inicioKmer);
+        hayActual = true;
+        minimoActual = minimo;
+        inicioActual = inicioKmer;
+        kmers++;
+    }
+
+    // Termina el segmento: entrega el super-k-mer pendiente y reinicia la ventana
+    template<typename Salida>
+    void cerrar(Salida& salida) {
+        entregar(vistas, salida);
+        rodanteM.reset();
+        bases.clear();
+        inicioBases = 0;
+        vistas = 0;
+        ventana.clear();
+    }
+
+    long long getKmers() const { return kmers; }
+};
+
+/**
+ * Conteo exacto de k-mers en dos fases, con particiones en disco por minimizador
+ *
+ * distribuir() recorre los genomas (en paralelo con repartirFragmentos, igual que la
+ * ingesta de los sketches) y escribe cada super-k-mer en el archivo de la partición de su
+ * minimizador, como un registro FASTA ">\n<bases>\n". Cada hilo junta lo de cada partición
+ * en un buffer y lo escribe de una vez al llegar a TAMANO_BUFFER, así que el disco recibe
+ * escrituras secuenciales grandes. Lo pendiente de un hilo entre todos sus buffers no pasa de
+ * MEMORIA_POR_HILO: al superarlo se vuelca el buffer más grande, de modo que la memoria de
+ * esta fase no crece con el número de particiones. Por lo mismo los archivos se abren (para
+ * agregar) solo mientras se escribe un buffer y nunca quedan abiertos todos a la vez.
+ *
+ * Todas las apariciones de un k-mer quedan en la misma partición, de modo que contar() puede
+ * contar cada una por separado con un ContadorExacto reservado para las apariciones de la
+ * partición: la memoria queda acotada por la partición más grande (una por hilo) y no por el
+ * total de k-mers distintos. Los archivos se borran apenas se cuentan y el resto al destruir
+ * el objeto.
+ */
+class ParticionMinimizadores {
+private:
+    static const size_t TAMANO_BUFFER = 64 << 10;
+    static const size_t MEMORIA_POR_HILO = 8 << 20;
+
+    // lo pendiente de escribir en una partición desde un hilo
+    struct BufferParticion {
+        std::string texto;
+        size_t kmers = 0;
+    };
+
+    std::vector<int> ks;
+    int particiones;
+    std::string directorio;
+    std::vector<std::string> rutas;         // [indiceK * particiones + particion]
+    std::vector<size_t> kmersParticion;     // apariciones de k-mers escritas en cada ruta
+    std::vector<long long> totales;         // k-mers por k
+    std::vector<size_t> bytes;              // bytes escritos por k
+
+    std::string ruta(size_t indiceK, int particion) const {
+        char nombre[64];
+        std::snprintf(nombre, sizeof(nombre), "/particion_%dmer_%04d.fa", ks[indiceK], particion);
+        return directorio + nombre;
+    }
+
+public:
+    /**
+     * @param ks Longitudes de k-mer a contar (1 a 32)
+     * @param particiones Archivos por cada k
+     * @param directorio Directorio para los archivos temporales; se crea si no existe
+     */
+    ParticionMinimizadores(const std::vector<int>& ks, int particiones, const std::string& directorio)
+        : ks(ks), particiones(particiones), directorio(directorio), totales(ks.size(), 0), bytes(ks.size(), 0) {
+        ExtractorMultiK validar(ks);
+        if (particiones <= 0) {
+            throw std::invalid_argument("El número de particiones debe ser positivo");
+        }
+        std::filesystem::create_directories(directorio);
+        for (size_t i = 0; i < ks.size(); i++) {
+            for (int b = 0; b < particiones; b++) rutas.push_back(ruta(i, b));
+        }
+    }
+
+    ParticionMinimizadores(const ParticionMinimizadores&) = delete;
+    ParticionMinimizadores& operator=(const ParticionMinimizadores&) = delete;
+
+    ~ParticionMinimizadores() {
+        std::error_code ignorado;
+        for (const std::string& r : rutas) std::filesystem::remove(r, ignorado);
+        std::filesystem::remove(directorio, ignorado); // solo si quedó vacío
+    }
+
+    // Largo del minimizador para k: la mitad, para que haya muchos minimizadores distintos
+    static int largoMinimizador(int k) {
+        return (k + 1) / 2;
+    }
+
+    /**
+     * Fase 1: reparte los k-mers de todos los archivos del lector en las particiones
+     * @param hilos Hilos que recorren los fragmentos (0 = hardware_concurrency)
+     */
+    void distribuir(LectorGenomas& lector, int hilos) {
+        if (hilos <= 0) hilos = hilosDisponibles();
+        const size_t m = ks.size();
+        const int kMax = ExtractorMultiK(ks).getKMax();
+
+        // los archivos se crean al primer volcado; se descartan los de una ejecución anterior
+        for (const std::string& r : rutas) std::remove(r.c_str());
+        const size_t archivos = rutas.size();
+        kmersParticion.assign(archivos, 0);
+        std::vector<std::mutex> candados(archivos);
+        std::vector<std::vector<BufferParticion>> buffers(hilos, std::vector<BufferParticion>(archivos));
+        std::vector<size_t> pendientes(hilos, 0);  // bytes en los buffers de cada hilo
+        std::vector<std::vector<long long>> kmersPorHilo(hilos, std::vector<long long>(m, 0));
+        std::vector<size_t> escritos(archivos, 0);
+        std::atomic<bool> errorEscritura(false);
+
+        // escribe y libera el buffer de un hilo
+        auto volcar = [&](int h, size_t archivo) {
+            BufferParticion& buffer = buffers[h][archivo];
+            {
+                std::lock_guard<std::mutex> lock(candados[archivo]);
+                FILE* f = std::fopen(rutas[archivo].c_str(), "ab");
+                if (f == nullptr || std::fwrite(buffer.texto.data(), 1, buffer.texto.size(), f) != buffer.texto.size()) {
+                    errorEscritura = true;
+                }
+                if (f != nullptr && std::fclose(f) != 0) errorEscritura = true;
+                escritos[archivo] += buffer.texto.size();
+                kmersParticion[archivo] += buffer.kmers;
+            }
+            pendientes[h] -= buffer.texto.size();
+            std::string().swap(buffer.texto);
+            buffer.kmers = 0;
+        };
+
+        // vuelca el buffer más grande del hilo hasta volver a MEMORIA_POR_HILO
+        auto ajustarMemoria = [&](int h) {
+            while (pendientes[h] > MEMORIA_POR_HILO) {
+                size_t mayor = 0;
+                for (size_t a = 1; a < archivos; a++) {
+                    if (buffers[h][a].texto.size() > buffers[h][mayor].texto.size()) mayor = a;
+                }
+                volcar(h, mayor);
+            }
+        };
+
+        repartirFragmentos(lector, kMax, hilos, [&](int h, const FragmentoSecuencia& fragmento) {
+            const char* datos = fragmento.archivo.datos;
+            const size_t desde = fragmento.archivo.solape;
+            std::vector<size_t> hasta(m);
+            std::vector<ConstructorSuperKmers> constructores;
+            std::vector<std::function<void(uint64_t, const char*, size_t)>> salidas;
+            for (size_t i = 0; i < m; i++) {
+                // un k-mer que empieza en corte o después es del fragmento siguiente
+                hasta[i] = avanzarBases(datos, fragmento.fin, fragmento.corte, ks[i] - 1);
+                constructores.emplace_back(ks[i], largoMinimizador(ks[i]));
+                salidas.emplace_back([&, i](uint64_t minimo, const char* bases, size_t n) {
+                    // el minimizador es el menor de varios hashes: se vuelve a mezclar para repartir parejo
+                    uint64_t mezcla = mixhash64(minimo, 1);
+                    size_t archivo = i * particiones + (size_t)(((unsigned __int128)mezcla * particiones) >> 64);
+                    BufferParticion& buffer = buffers[h][archivo];
+                    buffer.texto += ">\n";
+                    buffer.texto.append(bases, n);
+                    buffer.texto += '\n';
+                    buffer.kmers += n - (ks[i] - 1);
+                    pendientes[h] += n + 3;
+                    if (buffer.texto.size() >= TAMANO_BUFFER) volcar(h, archivo);
+                    else ajustarMemoria(h);
+                });
+            }
+            auto cerrarTodos = [&]() {
+                for (size_t i = 0; i < m; i++) constructores[i].cerrar(salidas[i]);
+            };
+
+            bool enCabecera = false;
+            size_t p = fragmento.inicio;
+            while (p < fragmento.fin) {
+                if (enCabecera) {
+                    const void* finLinea = std::memchr(datos + p, '\n', fragmento.fin - p);
+                    if (finLinea == nullptr) break;
+                    p = static_cast<const char*>(finLinea) - datos + 1;
+                    enCabecera = false;
+                    continue;
+                }
+                char c = datos[p++];
+                uint8_t b = codificarBase(c);
+                if (b != BASE_INVALIDA) {
+                    for (size_t i = 0; i < m; i++) {
+                        if (p <= hasta[i]) constructores[i].agregar(c, b, p > desde, salidas[i]);
+                        else constructores[i].cerrar(salidas[i]);
+                    }
+                } else if (c == '>') {
+                    cerrarTodos(); // nuevo registro
+                    enCabecera = true;
+                } else if (c != '\n' && c != '\r') {
+                    cerrarTodos(); // N u otra base inválida
+                }
+            }
+            cerrarTodos();
+            for (size_t i = 0; i < m; i++) kmersPorHilo[h][i] += constructores[i].getKmers();
+        });
+
+        for (int h = 0; h < hilos; h++) {
+            for (size_t a = 0; a < archivos; a++) {
+                if (!buffers[h][a].texto.empty()) volcar(h, a);
+            }
+            for (size_t i = 0; i < m; i++) totales[i] += kmersPorHilo[h][i];
+        }
+        for (size_t a = 0; a < archivos; a++) bytes[a / particiones] += escritos[a];
+        if (errorEscritura) {
+            throw std::runtime_error("Error escribiendo las particiones en " + directorio);
+        }
+    }
+
+    /**
+     * Fase 2: cuenta cada partición de ks[indiceK] por separado y borra su archivo
+     * @param procesar Función procesar(int hilo, const ContadorExacto& conteo), llamada una vez
+     *                 por partición con sus cuentas exactas; cada k-mer aparece en una sola
+     */
+    template<typename Procesar>
+    void contar(size_t indiceK, int hilos, Procesar procesar) {
+        if (hilos <= 0) hilos = hilosDisponibles();
+        const int k = ks[indiceK];
+        std::atomic<int> siguiente(0);
+        std::exception_ptr error;
+        std::mutex mutexError;
+
+        auto trabajar = [&](int h) {
+            try {
+                std::vector<uint64_t> lote(LectorGenomas::TAMANO_LOTE);
+                int b;
+                while ((b = siguiente.fetch_add(1)) < particiones) {
+                    {
+                        std::lock_guard<std::mutex> lock(mutexError);
+                        if (error) return;
+                    }
+                    const size_t indice = indiceK * particiones + b;
+                    const std::string& r = rutas[indice];
+                    // las apariciones de la partición acotan sus k-mers distintos: la tabla no
+                    // se duplica mientras se cuenta. Una partición sin apariciones no tiene archivo.
+                    ContadorExacto conteo(kmersParticion[indice]);
+                    if (kmersParticion[indice] > 0) {
+                        ArchivoMapeado archivo(r);
+                        ExtractorKmers extractor(k);
+                        size_t pos = 0, n;
+                        while ((n = extractor.extraer(archivo.data(), archivo.size(), pos, lote.data(), lote.size())) > 0) {
+                            conteo.insertBatch(lote.data(), n);
+                        }
+                    }
+                    std::remove(r.c_str());
+                    procesar(h, conteo);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutexError);
+                if (!error) error = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> trabajadores;
+        for (int h = 1; h < hilos; h++) trabajadores.emplace_back(trabajar, h);
+        trabajar(0);
+        for (auto& t : trabajadores) t.join();
+        if (error) std::rethrow_exception(error);
+    }
+
+    const std::vector<int>& getKs() const { return ks; }
+    int getParticiones() const { return particiones; }
+    long long getTotal(size_t indiceK) const { return totales[indiceK]; }
+    size_t getBytes(size_t indiceK) const { return bytes[indiceK]; }
+};
+
+#endif // PARTICIONMINIMIZADORES_H